@@ -0,0 +1,1708 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+#include <adbg.h>
+#include "optee_test.h"
+#include "xtest_benchmark.h"
+#include "xtest_helpers.h"
+
+#include <tee_client_api.h>
+#include <teec_ta_load.h>
+
+extern TEEC_Context xtest_teec_ctx;
+
+void *core_benchmark_init(void)
+{
+	printk("Begin Test suite core_benchmark\n");
+	(void)TEEC_InitializeContext(NULL, &xtest_teec_ctx);
+	return NULL;
+}
+
+void core_benchmark_deinit(void *param)
+{
+	(void)param;
+	printk("End Test suite core_benchmark\n");
+	TEEC_FinalizeContext(&xtest_teec_ctx);
+}
+
+/*
+ * TA lookup table generated from TA_DEPLOY_DIR (scripts/gen_ta_src.py),
+ * absent when the TAs are not embedded in the image
+ */
+extern struct ta_table table[] __weak;
+
+/* Size of the embedded binary of TA @uuid, 0 if unknown */
+static size_t ta_binary_size(const TEEC_UUID *uuid)
+{
+	struct ta_table *t = NULL;
+	char str[37] = { };
+
+	snprintf(str, sizeof(str),
+		 "%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+		 uuid->timeLow, uuid->timeMid, uuid->timeHiAndVersion,
+		 uuid->clockSeqAndNode[0], uuid->clockSeqAndNode[1],
+		 uuid->clockSeqAndNode[2], uuid->clockSeqAndNode[3],
+		 uuid->clockSeqAndNode[4], uuid->clockSeqAndNode[5],
+		 uuid->clockSeqAndNode[6], uuid->clockSeqAndNode[7]);
+
+	for (t = table; t && t->uuid; t++) {
+		if (!strcmp(t->uuid, str))
+			return t->ta_size;
+	}
+
+	return 0;
+}
+
+/*
+ * Session open latency
+ *
+ * For TAs of various binary sizes, times the first open of the test (a
+ * TA load, unless a previous suite left an instance alive), repeated
+ * opens with no live instance, where the TA is loaded again from the TA
+ * table through the supplicant each time, and repeated opens while
+ * another session keeps an instance alive. The latter only skips the
+ * load for single instance TAs; sims_keepalive stays loaded even once
+ * its last session is closed.
+ */
+#define OPEN_ITERATIONS		16
+
+static const struct {
+	const char *name;
+	const TEEC_UUID *uuid;
+	bool keep_alive;
+} open_tas[] = {
+	{ "os_test", &os_test_ta_uuid, false },
+	{ "sims_test", &sims_test_ta_uuid, false },
+	{ "sims_keepalive", &sims_keepalive_test_ta_uuid, true },
+	{ "crypt", &crypt_user_ta_uuid, false },
+	{ "large", &large_ta_uuid, false },
+};
+
+static TEEC_Result open_batch(const TEEC_UUID *uuid,
+			      struct xtest_bench_stats *stats)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session sess = { };
+	uint32_t ret_orig = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	xtest_bench_stats_reset(stats);
+
+	for (n = 0; n < OPEN_ITERATIONS; n++) {
+		t = xtest_bench_now_ns();
+		res = xtest_teec_open_session(&sess, uuid, NULL, &ret_orig);
+		t = xtest_bench_now_ns() - t;
+		if (res != TEEC_SUCCESS)
+			return res;
+
+		xtest_bench_stats_add(stats, t);
+		TEEC_CloseSession(&sess);
+	}
+
+	return TEEC_SUCCESS;
+}
+
+static void open_bench(ADBG_Case_t *c, size_t idx,
+		       struct xtest_bench_stats *stats)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	const TEEC_UUID *uuid = open_tas[idx].uuid;
+	const char *name = open_tas[idx].name;
+	TEEC_Session live = { };
+	uint32_t ret_orig = 0;
+	char label[48] = { };
+	uint64_t t = 0;
+
+	t = xtest_bench_now_ns();
+	res = xtest_teec_open_session(&live, uuid, NULL, &ret_orig);
+	t = xtest_bench_now_ns() - t;
+	if (res == TEEC_ERROR_ITEM_NOT_FOUND) {
+		Do_ADBG_Log("    %s: TA not found, skipped", name);
+		return;
+	}
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		return;
+	TEEC_CloseSession(&live);
+
+	Do_ADBG_Log("    %s: %zu bytes binary, first open " XTEST_BENCH_US_FMT
+		    " us", name, ta_binary_size(uuid), XTEST_BENCH_US(t));
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, open_batch(uuid, stats)))
+		return;
+
+	snprintf(label, sizeof(label), "%s, %s", name,
+		 open_tas[idx].keep_alive ? "kept alive" : "no live instance");
+	xtest_bench_stats_print(label, stats);
+
+	res = xtest_teec_open_session(&live, uuid, NULL, &ret_orig);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		return;
+
+	res = open_batch(uuid, stats);
+	if (res == TEEC_ERROR_BUSY) {
+		Do_ADBG_Log("    %s: single session TA, no second session",
+			    name);
+	} else if (ADBG_EXPECT_TEEC_SUCCESS(c, res)) {
+		snprintf(label, sizeof(label), "%s, live session", name);
+		xtest_bench_stats_print(label, stats);
+	}
+
+	TEEC_CloseSession(&live);
+}
+
+ZTEST(core_benchmark, test_1001)
+{
+	struct xtest_bench_stats stats = { };
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("Session open latency");
+
+	if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&stats,
+						       OPEN_ITERATIONS))) {
+		ADBG_Assert(&c);
+		return;
+	}
+
+	if (!table)
+		Do_ADBG_Log("    No TA table in the image, TA sizes unknown");
+
+	for (n = 0; n < ARRAY_SIZE(open_tas); n++)
+		open_bench(&c, n, &stats);
+
+	xtest_bench_stats_free(&stats);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Parameter marshalling cost
+ *
+ * Times PTA_INVOKE_TESTS_CMD_PARAMS invocations carrying 0 to 4 parameters
+ * of one kind, for buffers of 0 B to 1 MiB for the memory reference
+ * kinds. The pseudo TA only processes a single value or memref inout and
+ * rejects any other combination once the parameters have been mapped,
+ * so every invocation which reaches it measures the marshalling cost; an
+ * error returned by the TEE core or the client instead means the
+ * parameters could not be passed at all and the cell is left empty.
+ */
+#define MARSHAL_ITERATIONS	64
+#define MARSHAL_MAX_PARAMS	4
+
+enum marshal_shm {
+	MARSHAL_SHM_NONE,
+	MARSHAL_SHM_ALLOCATED,
+	MARSHAL_SHM_REGISTERED,
+};
+
+struct marshal_kind {
+	const char *name;
+	uint32_t type;
+	enum marshal_shm shm;
+	bool memref;
+};
+
+static const struct marshal_kind marshal_kinds[] = {
+	{ "value in", TEEC_VALUE_INPUT, MARSHAL_SHM_NONE, false },
+	{ "value out", TEEC_VALUE_OUTPUT, MARSHAL_SHM_NONE, false },
+	{ "value inout", TEEC_VALUE_INOUT, MARSHAL_SHM_NONE, false },
+	{ "tmpref", TEEC_MEMREF_TEMP_INOUT, MARSHAL_SHM_NONE, true },
+	{ "whole", TEEC_MEMREF_WHOLE, MARSHAL_SHM_ALLOCATED, true },
+	{ "partial", TEEC_MEMREF_PARTIAL_INOUT, MARSHAL_SHM_ALLOCATED, true },
+	{ "registered", TEEC_MEMREF_WHOLE, MARSHAL_SHM_REGISTERED, true },
+};
+
+static const size_t marshal_sizes[] = {
+	0, 64, 4 * 1024, 64 * 1024, 1024 * 1024,
+};
+
+static void marshal_op(TEEC_Operation *op, const struct marshal_kind *k,
+		       size_t nparams, void *buf, size_t size,
+		       TEEC_SharedMemory *shm)
+{
+	uint32_t types[MARSHAL_MAX_PARAMS] = { };
+	size_t n = 0;
+
+	memset(op, 0, sizeof(*op));
+
+	for (n = 0; n < nparams; n++) {
+		types[n] = k->type;
+		if (k->shm != MARSHAL_SHM_NONE) {
+			op->params[n].memref.parent = shm;
+			op->params[n].memref.offset = 0;
+			op->params[n].memref.size = size;
+		} else if (k->memref) {
+			op->params[n].tmpref.buffer = buf;
+			op->params[n].tmpref.size = size;
+		} else {
+			op->params[n].value.a = n;
+			op->params[n].value.b = size;
+		}
+	}
+
+	op->paramTypes = TEEC_PARAM_TYPES(types[0], types[1], types[2],
+					  types[3]);
+}
+
+static TEEC_Result marshal_time(TEEC_Session *sess,
+				const struct marshal_kind *k, size_t nparams,
+				void *buf, size_t size, TEEC_SharedMemory *shm,
+				struct xtest_bench_stats *stats)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
+	uint32_t ret_orig = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	xtest_bench_stats_reset(stats);
+
+	for (n = 0; n < MARSHAL_ITERATIONS; n++) {
+		marshal_op(&op, k, nparams, buf, size, shm);
+
+		t = xtest_bench_now_ns();
+		res = TEEC_InvokeCommand(sess, PTA_INVOKE_TESTS_CMD_PARAMS, &op,
+					 &ret_orig);
+		t = xtest_bench_now_ns() - t;
+		if (res != TEEC_SUCCESS && ret_orig != TEEC_ORIGIN_TRUSTED_APP)
+			return res;
+
+		xtest_bench_stats_add(stats, t);
+	}
+
+	return TEEC_SUCCESS;
+}
+
+/* One line of the matrix: median latency for 1 to 4 parameters */
+static void marshal_row(TEEC_Session *sess, const struct marshal_kind *k,
+			void *buf, size_t size,
+			struct xtest_bench_stats *stats)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_SharedMemory shm = { };
+	char line[128] = { };
+	char label[32] = { };
+	uint64_t p50 = 0;
+	size_t nparams = 0;
+	int len = 0;
+
+	if (k->memref)
+		snprintk(label, sizeof(label), "%s %zu B", k->name, size);
+	else
+		snprintk(label, sizeof(label), "%s", k->name);
+
+	shm.size = size;
+	shm.flags = TEEC_MEM_INPUT | TEEC_MEM_OUTPUT;
+	if (k->shm == MARSHAL_SHM_ALLOCATED) {
+		res = TEEC_AllocateSharedMemory(&xtest_teec_ctx, &shm);
+	} else if (k->shm == MARSHAL_SHM_REGISTERED) {
+		shm.buffer = buf;
+		res = TEEC_RegisterSharedMemory(&xtest_teec_ctx, &shm);
+	} else {
+		res = TEEC_SUCCESS;
+	}
+	if (res != TEEC_SUCCESS) {
+		Do_ADBG_Log("    %-24s shared memory setup failed: 0x%08x",
+			    label, res);
+		return;
+	}
+
+	len = snprintk(line, sizeof(line), "    %-24s", label);
+	for (nparams = 1; nparams <= MARSHAL_MAX_PARAMS; nparams++) {
+		res = marshal_time(sess, k, nparams, buf, size, &shm, stats);
+		if (res != TEEC_SUCCESS) {
+			len += snprintk(line + len, sizeof(line) - len,
+					" %12s", "-");
+			continue;
+		}
+
+		p50 = xtest_bench_stats_percentile(stats, 50);
+		len += snprintk(line + len, sizeof(line) - len,
+				" %8" PRIu64 ".%03" PRIu64, XTEST_BENCH_US(p50));
+	}
+	Do_ADBG_Log("%s", line);
+
+	if (k->shm != MARSHAL_SHM_NONE)
+		TEEC_ReleaseSharedMemory(&shm);
+}
+
+ZTEST(core_benchmark, test_1002)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session session = { };
+	struct xtest_bench_stats stats = { };
+	const struct marshal_kind *k = NULL;
+	size_t max_size = marshal_sizes[ARRAY_SIZE(marshal_sizes) - 1];
+	uint32_t ret_orig = 0;
+	uint8_t *buf = NULL;
+	size_t n = 0;
+	size_t m = 0;
+	ADBG_STRUCT_DECLARE("Parameter marshalling latency");
+
+	res = xtest_teec_open_session(&session, &pta_invoke_tests_ta_uuid,
+				      NULL, &ret_orig);
+	if (res == TEEC_ERROR_ITEM_NOT_FOUND) {
+		Do_ADBG_Log("    Pseudo TA not found, skipped");
+		return;
+	}
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, res)) {
+		ADBG_Assert(&c);
+		return;
+	}
+
+	if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&stats,
+						       MARSHAL_ITERATIONS)))
+		goto out;
+
+	buf = k_malloc(max_size);
+	if (!ADBG_EXPECT_NOT_NULL(&c, buf))
+		goto out;
+	memset(buf, 0x5a, max_size);
+
+	/* Baseline: no parameter at all */
+	res = marshal_time(&session, &marshal_kinds[0], 0, NULL, 0, NULL,
+			   &stats);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, res))
+		goto out;
+	xtest_bench_stats_print("no parameter", &stats);
+
+	Do_ADBG_Log("    %-24s %12s %12s %12s %12s", "median latency, us",
+		    "1 param", "2 params", "3 params", "4 params");
+	for (n = 0; n < ARRAY_SIZE(marshal_kinds); n++) {
+		k = &marshal_kinds[n];
+		if (!k->memref) {
+			marshal_row(&session, k, NULL, 0, &stats);
+			continue;
+		}
+
+		for (m = 0; m < ARRAY_SIZE(marshal_sizes); m++)
+			marshal_row(&session, k, buf, marshal_sizes[m], &stats);
+	}
+
+out:
+	k_free(buf);
+	xtest_bench_stats_free(&stats);
+	TEEC_CloseSession(&session);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Shared memory bandwidth
+ *
+ * Moves buffers of 4 KiB to 16 MiB through PTA_INVOKE_TESTS_CMD_PARAMS,
+ * which reads the whole inout memref in the secure world, as a tmpref,
+ * through allocated shared memory the data is copied into and back out
+ * of, and through the application buffer registered as shared memory.
+ * For each flavor the setup and teardown cost, the bandwidth when the
+ * shared memory is set up for a single transfer and the bandwidth when
+ * it is reused are reported, together with the number of transfers per
+ * buffer from which the allocated and registered flavors beat tmpref.
+ * Sizes and flavors which do not fit in memory are skipped.
+ */
+#define SHM_BW_BYTES		(32 * 1024 * 1024)
+#define SHM_BW_MIN_ITERATIONS	4
+#define SHM_BW_MAX_ITERATIONS	64
+
+enum shm_flavor {
+	SHM_TMPREF,
+	SHM_ALLOCATED,
+	SHM_REGISTERED,
+	SHM_FLAVOR_COUNT,
+};
+
+static const char * const shm_flavor_names[SHM_FLAVOR_COUNT] = {
+	[SHM_TMPREF] = "tmpref",
+	[SHM_ALLOCATED] = "allocated",
+	[SHM_REGISTERED] = "registered",
+};
+
+static const size_t shm_bw_sizes[] = {
+	4 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024,
+	16 * 1024 * 1024,
+};
+
+/* Average cost per buffer, in nanoseconds */
+struct shm_bw_result {
+	uint64_t setup_ns;
+	uint64_t oneshot_ns;
+	uint64_t steady_ns;
+};
+
+static TEEC_Result shm_setup(enum shm_flavor f, TEEC_SharedMemory *shm,
+			     void *buf, size_t size)
+{
+	memset(shm, 0, sizeof(*shm));
+	shm->size = size;
+	shm->flags = TEEC_MEM_INPUT | TEEC_MEM_OUTPUT;
+
+	if (f == SHM_ALLOCATED)
+		return TEEC_AllocateSharedMemory(&xtest_teec_ctx, shm);
+
+	if (f == SHM_REGISTERED) {
+		shm->buffer = buf;
+		return TEEC_RegisterSharedMemory(&xtest_teec_ctx, shm);
+	}
+
+	return TEEC_SUCCESS;
+}
+
+static void shm_teardown(enum shm_flavor f, TEEC_SharedMemory *shm)
+{
+	if (f != SHM_TMPREF)
+		TEEC_ReleaseSharedMemory(shm);
+}
+
+static TEEC_Result shm_transfer(TEEC_Session *sess, enum shm_flavor f,
+				TEEC_SharedMemory *shm, void *buf, size_t size)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
+	uint32_t ret_orig = 0;
+
+	if (f == SHM_TMPREF) {
+		op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INOUT,
+						 TEEC_NONE, TEEC_NONE,
+						 TEEC_NONE);
+		op.params[0].tmpref.buffer = buf;
+		op.params[0].tmpref.size = size;
+	} else {
+		if (f == SHM_ALLOCATED)
+			memcpy(shm->buffer, buf, size);
+		op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_WHOLE, TEEC_NONE,
+						 TEEC_NONE, TEEC_NONE);
+		op.params[0].memref.parent = shm;
+	}
+
+	res = TEEC_InvokeCommand(sess, PTA_INVOKE_TESTS_CMD_PARAMS, &op,
+				 &ret_orig);
+	if (res == TEEC_SUCCESS && f == SHM_ALLOCATED)
+		memcpy(buf, shm->buffer, size);
+
+	return res;
+}
+
+static TEEC_Result shm_bw_measure(TEEC_Session *sess, enum shm_flavor f,
+				  void *buf, size_t size, size_t iterations,
+				  struct shm_bw_result *r)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_SharedMemory shm = { };
+	uint64_t t = 0;
+	size_t n = 0;
+
+	/* Set up for a single transfer */
+	t = xtest_bench_now_ns();
+	for (n = 0; n < iterations; n++) {
+		res = shm_setup(f, &shm, buf, size);
+		if (res != TEEC_SUCCESS)
+			return res;
+		res = shm_transfer(sess, f, &shm, buf, size);
+		shm_teardown(f, &shm);
+		if (res != TEEC_SUCCESS)
+			return res;
+	}
+	r->oneshot_ns = (xtest_bench_now_ns() - t) / iterations;
+
+	t = xtest_bench_now_ns();
+	for (n = 0; n < iterations; n++) {
+		res = shm_setup(f, &shm, buf, size);
+		if (res != TEEC_SUCCESS)
+			return res;
+		shm_teardown(f, &shm);
+	}
+	r->setup_ns = (xtest_bench_now_ns() - t) / iterations;
+
+	res = shm_setup(f, &shm, buf, size);
+	if (res != TEEC_SUCCESS)
+		return res;
+
+	t = xtest_bench_now_ns();
+	for (n = 0; n < iterations; n++) {
+		res = shm_transfer(sess, f, &shm, buf, size);
+		if (res != TEEC_SUCCESS)
+			break;
+	}
+	r->steady_ns = (xtest_bench_now_ns() - t) / iterations;
+
+	shm_teardown(f, &shm);
+
+	return res;
+}
+
+static void shm_bw_size(ADBG_Case_t *c, TEEC_Session *sess, size_t size)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	struct shm_bw_result r[SHM_FLAVOR_COUNT] = { };
+	size_t iterations = SHM_BW_BYTES / size;
+	uint64_t gain = 0;
+	uint8_t *buf = NULL;
+	size_t f = 0;
+
+	iterations = CLAMP(iterations, SHM_BW_MIN_ITERATIONS,
+			   SHM_BW_MAX_ITERATIONS);
+
+	buf = k_malloc(size);
+	if (!buf) {
+		Do_ADBG_Log("    %zu KiB: not enough memory, skipped",
+			    size / 1024);
+		return;
+	}
+	memset(buf, 0x5a, size);
+
+	Do_ADBG_Log("    %zu KiB, %zu transfers:", size / 1024, iterations);
+	for (f = 0; f < SHM_FLAVOR_COUNT; f++) {
+		res = shm_bw_measure(sess, f, buf, size, iterations, &r[f]);
+		if (res == TEEC_ERROR_OUT_OF_MEMORY) {
+			Do_ADBG_Log("      %-10s not enough memory, skipped",
+				    shm_flavor_names[f]);
+			continue;
+		}
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+			goto out;
+
+		Do_ADBG_Log("      %-10s setup " XTEST_BENCH_US_FMT
+			    " us, single use " XTEST_BENCH_MILLI_FMT
+			    " MiB/s, reused " XTEST_BENCH_MILLI_FMT " MiB/s",
+			    shm_flavor_names[f], XTEST_BENCH_US(r[f].setup_ns),
+			    XTEST_BENCH_MILLI(xtest_bench_mib_milli(size,
+							r[f].oneshot_ns)),
+			    XTEST_BENCH_MILLI(xtest_bench_mib_milli(size,
+							r[f].steady_ns)));
+	}
+
+	if (!r[SHM_TMPREF].steady_ns)
+		goto out;
+
+	/* Setup cost amortized over the transfers saved against tmpref */
+	for (f = SHM_ALLOCATED; f < SHM_FLAVOR_COUNT; f++) {
+		if (!r[f].steady_ns)
+			continue;
+
+		if (r[f].steady_ns >= r[SHM_TMPREF].steady_ns) {
+			Do_ADBG_Log("      %s never beats tmpref",
+				    shm_flavor_names[f]);
+			continue;
+		}
+
+		gain = r[SHM_TMPREF].steady_ns - r[f].steady_ns;
+		Do_ADBG_Log("      %s beats tmpref from %" PRIu64
+			    " transfers per buffer", shm_flavor_names[f],
+			    r[f].setup_ns / gain + 1);
+	}
+
+out:
+	k_free(buf);
+}
+
+ZTEST(core_benchmark, test_1003)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session session = { };
+	uint32_t ret_orig = 0;
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("Shared memory bandwidth");
+
+	res = xtest_teec_open_session(&session, &pta_invoke_tests_ta_uuid,
+				      NULL, &ret_orig);
+	if (res == TEEC_ERROR_ITEM_NOT_FOUND) {
+		Do_ADBG_Log("    Pseudo TA not found, skipped");
+		return;
+	}
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, res)) {
+		ADBG_Assert(&c);
+		return;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(shm_bw_sizes); n++)
+		shm_bw_size(&c, &session, shm_bw_sizes[n]);
+
+	TEEC_CloseSession(&session);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Shared memory allocation churn
+ *
+ * 1, 2 and 8 threads each run CHURN_OPS random operations on their own
+ * CHURN_SLOTS shared memory slots: an empty slot is filled with allocated
+ * or registered shared memory of a random size, a used one is released.
+ * Registered shared memory is backed by a k_malloc() buffer. Allocation,
+ * registration and release latencies are accumulated over all threads,
+ * out of memory failures are counted together with the live shared
+ * memory when the first one happened, and the system heap usage and
+ * fragmentation are compared before and after each run.
+ */
+#define CHURN_MAX_THREADS	8
+#define CHURN_OPS		256
+#define CHURN_SLOTS		8
+#define CHURN_SEED		0x6b8b4567
+#define CHURN_STACK_SIZE	(2048 + CONFIG_TEST_EXTRA_STACK_SIZE)
+
+static const size_t churn_sizes[] = {
+	64, 512, 4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024,
+};
+
+static const size_t churn_threads[] = { 1, 2, CHURN_MAX_THREADS };
+
+struct churn_slot {
+	TEEC_SharedMemory shm;
+	/* Registered buffer, NULL for allocated shared memory */
+	void *buf;
+	bool used;
+};
+
+struct churn_arg {
+	size_t index;
+	struct churn_slot slots[CHURN_SLOTS];
+	size_t failures;
+	size_t first_failure_size;
+	size_t live_at_failure;
+	TEEC_Result res;
+};
+
+static struct k_thread churn_thr[CHURN_MAX_THREADS];
+static struct churn_arg churn_args[CHURN_MAX_THREADS];
+static K_THREAD_STACK_ARRAY_DEFINE(churn_stacks, CHURN_MAX_THREADS,
+				   CHURN_STACK_SIZE);
+
+static struct k_spinlock churn_lock;
+static struct xtest_bench_stats churn_alloc_stats;
+static struct xtest_bench_stats churn_reg_stats;
+static struct xtest_bench_stats churn_release_stats;
+/* Shared memory bytes currently held by all threads */
+static atomic_t churn_live_bytes;
+
+static void churn_account(struct xtest_bench_stats *s, uint64_t ns)
+{
+	k_spinlock_key_t key = k_spin_lock(&churn_lock);
+
+	xtest_bench_stats_add(s, ns);
+	k_spin_unlock(&churn_lock, key);
+}
+
+static void churn_release(struct churn_slot *s)
+{
+	size_t size = s->shm.size;
+	uint64_t t = xtest_bench_now_ns();
+
+	TEEC_ReleaseSharedMemory(&s->shm);
+	churn_account(&churn_release_stats, xtest_bench_now_ns() - t);
+
+	atomic_sub(&churn_live_bytes, size);
+	k_free(s->buf);
+	memset(s, 0, sizeof(*s));
+}
+
+static void churn_failure(struct churn_arg *a, size_t size)
+{
+	if (!a->failures++) {
+		a->first_failure_size = size;
+		a->live_at_failure = atomic_get(&churn_live_bytes);
+	}
+}
+
+/* Returns false on an error other than running out of memory */
+static bool churn_fill(struct churn_arg *a, struct churn_slot *s,
+		       size_t size, bool reg)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint64_t t = 0;
+
+	s->shm.size = size;
+	s->shm.flags = TEEC_MEM_INPUT | TEEC_MEM_OUTPUT;
+
+	if (reg) {
+		s->buf = k_malloc(size);
+		if (!s->buf) {
+			churn_failure(a, size);
+			return true;
+		}
+		s->shm.buffer = s->buf;
+
+		t = xtest_bench_now_ns();
+		res = TEEC_RegisterSharedMemory(&xtest_teec_ctx, &s->shm);
+		t = xtest_bench_now_ns() - t;
+	} else {
+		t = xtest_bench_now_ns();
+		res = TEEC_AllocateSharedMemory(&xtest_teec_ctx, &s->shm);
+		t = xtest_bench_now_ns() - t;
+	}
+
+	if (res != TEEC_SUCCESS) {
+		k_free(s->buf);
+		memset(s, 0, sizeof(*s));
+		if (res != TEEC_ERROR_OUT_OF_MEMORY) {
+			a->res = res;
+			return false;
+		}
+
+		churn_failure(a, size);
+		return true;
+	}
+
+	churn_account(reg ? &churn_reg_stats : &churn_alloc_stats, t);
+	atomic_add(&churn_live_bytes, size);
+	s->used = true;
+
+	return true;
+}
+
+static void churn_thread(void *arg1, void *arg2, void *arg3)
+{
+	struct churn_arg *a = arg1;
+	uint32_t seed = CHURN_SEED + a->index;
+	struct churn_slot *s = NULL;
+	size_t size = 0;
+	size_t n = 0;
+
+	for (n = 0; n < CHURN_OPS; n++) {
+		s = a->slots + xtest_bench_rand(&seed) % CHURN_SLOTS;
+		if (s->used) {
+			churn_release(s);
+			continue;
+		}
+
+		size = churn_sizes[xtest_bench_rand(&seed) %
+				   ARRAY_SIZE(churn_sizes)];
+		if (!churn_fill(a, s, size, xtest_bench_rand(&seed) & 1))
+			break;
+	}
+
+	for (n = 0; n < CHURN_SLOTS; n++) {
+		if (a->slots[n].used)
+			churn_release(a->slots + n);
+	}
+}
+
+static void churn_run(ADBG_Case_t *c, size_t nb_threads)
+{
+	struct xtest_bench_heap before = { };
+	struct xtest_bench_heap after = { };
+	size_t first_failure_size = SIZE_MAX;
+	size_t live_at_failure = 0;
+	size_t failures = 0;
+	k_tid_t tid = NULL;
+	size_t n = 0;
+	size_t i = 0;
+
+	xtest_bench_stats_reset(&churn_alloc_stats);
+	xtest_bench_stats_reset(&churn_reg_stats);
+	xtest_bench_stats_reset(&churn_release_stats);
+	memset(churn_args, 0, sizeof(churn_args));
+	atomic_set(&churn_live_bytes, 0);
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_heap_get(&before)))
+		return;
+
+	for (n = 0; n < nb_threads; n++) {
+		churn_args[n].index = n;
+		tid = k_thread_create(churn_thr + n, churn_stacks[n],
+				      CHURN_STACK_SIZE, churn_thread,
+				      churn_args + n, NULL, NULL,
+				      K_PRIO_PREEMPT(0), K_USER, K_NO_WAIT);
+		if (!ADBG_EXPECT_NOT(c, 0, (long)tid))
+			break;
+	}
+
+	for (i = 0; i < n; i++)
+		ADBG_EXPECT(c, 0, k_thread_join(churn_thr + i, K_FOREVER));
+
+	for (i = 0; i < n; i++) {
+		ADBG_EXPECT_TEEC_SUCCESS(c, churn_args[i].res);
+		failures += churn_args[i].failures;
+		if (churn_args[i].failures &&
+		    churn_args[i].first_failure_size < first_failure_size) {
+			first_failure_size = churn_args[i].first_failure_size;
+			live_at_failure = churn_args[i].live_at_failure;
+		}
+	}
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_heap_get(&after)))
+		return;
+
+	Do_ADBG_Log("    %zu threads:", nb_threads);
+	xtest_bench_stats_print("allocate", &churn_alloc_stats);
+	xtest_bench_stats_print("register", &churn_reg_stats);
+	xtest_bench_stats_print("release", &churn_release_stats);
+
+	if (failures)
+		Do_ADBG_Log("    %zu out of memory failures, smallest failed request %zu B with %zu B live",
+			    failures, first_failure_size, live_at_failure);
+	else
+		Do_ADBG_Log("    no out of memory failure");
+
+	xtest_bench_heap_print("heap before", &before);
+	xtest_bench_heap_print("heap after", &after);
+}
+
+ZTEST(core_benchmark, test_1005)
+{
+	size_t max_samples = CHURN_MAX_THREADS * CHURN_OPS;
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("Shared memory allocation churn");
+
+	if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&churn_alloc_stats,
+						       max_samples)) ||
+	    !ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&churn_reg_stats,
+						       max_samples)) ||
+	    !ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&churn_release_stats,
+						       max_samples)))
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(churn_threads); n++)
+		churn_run(&c, churn_threads[n]);
+
+out:
+	xtest_bench_stats_free(&churn_alloc_stats);
+	xtest_bench_stats_free(&churn_reg_stats);
+	xtest_bench_stats_free(&churn_release_stats);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Core mutex contention
+ *
+ * CONFIG_XTEST_BENCHMARK_MUTEX_THREADS threads, readers and writers in the
+ * configured proportion, take the core test read/write mutex through
+ * PTA_INVOKE_TESTS_CMD_MUTEX, holding it for the configured delay rounds,
+ * until CONFIG_XTEST_BENCHMARK_MUTEX_DURATION_MS have elapsed. Each
+ * invocation is one lock acquisition. Writer wait time is the invocation
+ * latency in excess of the median uncontended writer latency. Fairness
+ * within readers and within writers is Jain's index of the acquisitions
+ * per thread, 1 when all threads got the same share; threads which never
+ * got the lock are reported as starved.
+ */
+#define MUTEX_THREADS		CONFIG_XTEST_BENCHMARK_MUTEX_THREADS
+#define MUTEX_READERS		(MUTEX_THREADS * \
+				 CONFIG_XTEST_BENCHMARK_MUTEX_READER_PERCENT / \
+				 100)
+#define MUTEX_ROUNDS		CONFIG_XTEST_BENCHMARK_MUTEX_ROUNDS
+#define MUTEX_DURATION_MS	CONFIG_XTEST_BENCHMARK_MUTEX_DURATION_MS
+#define MUTEX_SAMPLES		1024
+#define MUTEX_BASE_ITERATIONS	16
+#define MUTEX_STACK_SIZE	(2048 + CONFIG_TEST_EXTRA_STACK_SIZE)
+
+struct mutex_arg {
+	uint32_t test_type;
+	struct xtest_bench_stats stats;
+	uint32_t max_readers;
+	TEEC_Result res;
+};
+
+static struct k_thread mutex_thr[MUTEX_THREADS];
+static struct mutex_arg mutex_args[MUTEX_THREADS];
+static K_THREAD_STACK_ARRAY_DEFINE(mutex_stacks, MUTEX_THREADS,
+				   MUTEX_STACK_SIZE);
+
+static atomic_t mutex_stop;
+static uint64_t mutex_base_ns;
+static struct k_spinlock mutex_wait_lock;
+static struct xtest_bench_stats mutex_wait_stats;
+
+/* Takes the mutex once, returns the lockers seen while holding it */
+static TEEC_Result mutex_invoke(TEEC_Session *sess, uint32_t test_type,
+				uint32_t *during)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
+	uint32_t ret_orig = 0;
+
+	op.params[0].value.a = test_type;
+	op.params[0].value.b = MUTEX_ROUNDS;
+	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_VALUE_OUTPUT,
+					 TEEC_NONE, TEEC_NONE);
+
+	res = TEEC_InvokeCommand(sess, PTA_INVOKE_TESTS_CMD_MUTEX, &op,
+				 &ret_orig);
+	*during = op.params[1].value.b;
+
+	/* A writer must be alone holding the mutex */
+	if (res == TEEC_SUCCESS && test_type == PTA_MUTEX_TEST_WRITER &&
+	    *during != 1)
+		res = TEEC_ERROR_BAD_STATE;
+
+	return res;
+}
+
+static void mutex_account_wait(uint64_t ns)
+{
+	k_spinlock_key_t key = k_spin_lock(&mutex_wait_lock);
+
+	xtest_bench_stats_add(&mutex_wait_stats,
+			      ns > mutex_base_ns ? ns - mutex_base_ns : 0);
+	k_spin_unlock(&mutex_wait_lock, key);
+}
+
+static void mutex_thread(void *arg1, void *arg2, void *arg3)
+{
+	struct mutex_arg *a = arg1;
+	TEEC_Session session = { };
+	uint32_t ret_orig = 0;
+	uint32_t during = 0;
+	uint64_t t = 0;
+
+	a->res = xtest_teec_open_session(&session, &pta_invoke_tests_ta_uuid,
+					 NULL, &ret_orig);
+	if (a->res != TEEC_SUCCESS)
+		return;
+
+	while (!atomic_get(&mutex_stop)) {
+		t = xtest_bench_now_ns();
+		a->res = mutex_invoke(&session, a->test_type, &during);
+		t = xtest_bench_now_ns() - t;
+		if (a->res != TEEC_SUCCESS)
+			break;
+
+		xtest_bench_stats_add(&a->stats, t);
+		if (a->test_type == PTA_MUTEX_TEST_WRITER)
+			mutex_account_wait(t);
+		else
+			a->max_readers = MAX(a->max_readers, during);
+	}
+
+	TEEC_CloseSession(&session);
+}
+
+/* Jain's index of the acquisitions per thread of a kind, scaled by 1000 */
+static uint64_t mutex_fairness(uint32_t test_type)
+{
+	uint64_t sum = 0;
+	uint64_t sum_sq = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	for (n = 0; n < MUTEX_THREADS; n++) {
+		if (mutex_args[n].test_type != test_type)
+			continue;
+
+		sum += mutex_args[n].stats.count;
+		sum_sq += (uint64_t)mutex_args[n].stats.count *
+			  mutex_args[n].stats.count;
+		count++;
+	}
+
+	if (!sum_sq)
+		return 0;
+
+	return sum * sum * 1000 / (count * sum_sq);
+}
+
+static bool mutex_baseline(ADBG_Case_t *c, TEEC_Session *sess)
+{
+	struct xtest_bench_stats stats = { };
+	uint32_t during = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&stats,
+						      MUTEX_BASE_ITERATIONS)))
+		return false;
+
+	for (n = 0; n < MUTEX_BASE_ITERATIONS; n++) {
+		t = xtest_bench_now_ns();
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, mutex_invoke(sess,
+					PTA_MUTEX_TEST_WRITER, &during)))
+			break;
+		xtest_bench_stats_add(&stats, xtest_bench_now_ns() - t);
+	}
+
+	mutex_base_ns = xtest_bench_stats_percentile(&stats, 50);
+	xtest_bench_stats_print("uncontended writer", &stats);
+	xtest_bench_stats_free(&stats);
+
+	return n == MUTEX_BASE_ITERATIONS;
+}
+
+ZTEST(core_benchmark, test_1006)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session session = { };
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	uint64_t start = 0;
+	uint64_t elapsed = 0;
+	uint32_t max_readers = 0;
+	uint32_t ret_orig = 0;
+	char label[32] = { };
+	k_tid_t tid = NULL;
+	size_t n = 0;
+	size_t i = 0;
+	ADBG_STRUCT_DECLARE("Core mutex contention");
+
+	res = xtest_teec_open_session(&session, &pta_invoke_tests_ta_uuid,
+				      NULL, &ret_orig);
+	if (res == TEEC_ERROR_ITEM_NOT_FOUND) {
+		Do_ADBG_Log("    Pseudo TA not found, skipped");
+		return;
+	}
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, res)) {
+		ADBG_Assert(&c);
+		return;
+	}
+
+	Do_ADBG_Log("    %d readers, %d writers, %d rounds, %d ms",
+		    MUTEX_READERS, MUTEX_THREADS - MUTEX_READERS, MUTEX_ROUNDS,
+		    MUTEX_DURATION_MS);
+
+	memset(mutex_args, 0, sizeof(mutex_args));
+	if (!mutex_baseline(&c, &session) ||
+	    !ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&mutex_wait_stats,
+					MUTEX_THREADS * MUTEX_SAMPLES)))
+		goto out;
+
+	for (n = 0; n < MUTEX_THREADS; n++) {
+		mutex_args[n].test_type = n < MUTEX_READERS ?
+					  PTA_MUTEX_TEST_READER :
+					  PTA_MUTEX_TEST_WRITER;
+		if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(
+					&mutex_args[n].stats, MUTEX_SAMPLES)))
+			goto out;
+	}
+
+	atomic_set(&mutex_stop, 0);
+	start = xtest_bench_now_ns();
+	for (n = 0; n < MUTEX_THREADS; n++) {
+		tid = k_thread_create(mutex_thr + n, mutex_stacks[n],
+				      MUTEX_STACK_SIZE, mutex_thread,
+				      mutex_args + n, NULL, NULL,
+				      K_PRIO_PREEMPT(0), K_USER, K_NO_WAIT);
+		if (!ADBG_EXPECT_NOT(&c, 0, (long)tid))
+			break;
+	}
+
+	k_msleep(MUTEX_DURATION_MS);
+	atomic_set(&mutex_stop, 1);
+
+	for (i = 0; i < n; i++)
+		ADBG_EXPECT(&c, 0, k_thread_join(mutex_thr + i, K_FOREVER));
+	elapsed = xtest_bench_now_ns() - start;
+
+	for (i = 0; i < n; i++) {
+		struct mutex_arg *a = mutex_args + i;
+		bool reader = a->test_type == PTA_MUTEX_TEST_READER;
+
+		ADBG_EXPECT_TEEC_SUCCESS(&c, a->res);
+
+		snprintk(label, sizeof(label), "%s %zu",
+			 reader ? "reader" : "writer", i);
+		xtest_bench_stats_print(label, &a->stats);
+		if (!a->stats.count)
+			Do_ADBG_Log("    %s starved", label);
+
+		if (reader)
+			reads += a->stats.count;
+		else
+			writes += a->stats.count;
+		max_readers = MAX(max_readers, a->max_readers);
+	}
+
+	Do_ADBG_Log("    %" PRIu64 " reads, %" PRIu64 " writes, "
+		    XTEST_BENCH_MILLI_FMT " acquisitions/s", reads, writes,
+		    XTEST_BENCH_MILLI(xtest_bench_rate_milli(reads + writes,
+							     elapsed)));
+	Do_ADBG_Log("    max concurrent readers %" PRIu32, max_readers);
+	Do_ADBG_Log("    fairness: readers " XTEST_BENCH_MILLI_FMT
+		    ", writers " XTEST_BENCH_MILLI_FMT,
+		    XTEST_BENCH_MILLI(mutex_fairness(PTA_MUTEX_TEST_READER)),
+		    XTEST_BENCH_MILLI(mutex_fairness(PTA_MUTEX_TEST_WRITER)));
+
+	if (mutex_wait_stats.count) {
+		xtest_bench_stats_print("writer wait", &mutex_wait_stats);
+		xtest_bench_stats_histogram(&mutex_wait_stats);
+	}
+
+out:
+	for (n = 0; n < MUTEX_THREADS; n++)
+		xtest_bench_stats_free(&mutex_args[n].stats);
+	xtest_bench_stats_free(&mutex_wait_stats);
+	TEEC_CloseSession(&session);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Session capacity
+ *
+ * Opens sessions to a TA one after the other, keeping them all open,
+ * until the TA or the TEE reports TEEC_ERROR_OUT_OF_MEMORY or
+ * TEEC_ERROR_BUSY, or CAP_MAX_SESSIONS are open. The open latency and the
+ * normal world heap allocated per open session are reported for each
+ * power of two band of session counts.
+ */
+#define CAP_MAX_SESSIONS	1024
+
+static const struct {
+	const char *name;
+	const TEEC_UUID *uuid;
+} cap_tas[] = {
+	{ "crypt", &crypt_user_ta_uuid },
+	{ "sims_test", &sims_test_ta_uuid },
+	{ "concurrent_large", &concurrent_large_ta_uuid },
+};
+
+static void cap_band_print(size_t first, size_t last, size_t heap_base,
+			   struct xtest_bench_stats *stats)
+{
+	struct xtest_bench_heap heap = { };
+	char label[32] = { };
+
+	snprintk(label, sizeof(label), "sessions %zu..%zu", first, last);
+	xtest_bench_stats_print(label, stats);
+
+	if (!xtest_bench_heap_get(&heap) && heap.allocated_bytes > heap_base)
+		Do_ADBG_Log("    %-40s %zu B heap per session", "",
+			    (heap.allocated_bytes - heap_base) / last);
+}
+
+static void cap_probe(ADBG_Case_t *c, size_t idx, TEEC_Session *sessions,
+		      struct xtest_bench_stats *stats)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	const char *name = cap_tas[idx].name;
+	struct xtest_bench_heap heap = { };
+	uint32_t ret_orig = 0;
+	size_t band_first = 1;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_heap_get(&heap)))
+		return;
+
+	xtest_bench_stats_reset(stats);
+
+	for (n = 0; n < CAP_MAX_SESSIONS; n++) {
+		t = xtest_bench_now_ns();
+		res = xtest_teec_open_session(sessions + n, cap_tas[idx].uuid,
+					      NULL, &ret_orig);
+		t = xtest_bench_now_ns() - t;
+		if (res != TEEC_SUCCESS)
+			break;
+
+		xtest_bench_stats_add(stats, t);
+
+		/* End of the [2^k, 2^(k+1)) band */
+		if (IS_POWER_OF_TWO(n + 2)) {
+			cap_band_print(band_first, n + 1,
+				       heap.allocated_bytes, stats);
+			xtest_bench_stats_reset(stats);
+			band_first = n + 2;
+		}
+	}
+
+	if (stats->count)
+		cap_band_print(band_first, n, heap.allocated_bytes, stats);
+
+	if (res == TEEC_ERROR_ITEM_NOT_FOUND && !n)
+		Do_ADBG_Log("    %s: TA not found, skipped", name);
+	else if (res == TEEC_ERROR_OUT_OF_MEMORY || res == TEEC_ERROR_BUSY)
+		Do_ADBG_Log("    %s: %zu sessions, next open failed with 0x%08x origin %" PRIu32,
+			    name, n, res, ret_orig);
+	else if (n == CAP_MAX_SESSIONS)
+		Do_ADBG_Log("    %s: no limit reached at %zu sessions", name, n);
+	else
+		ADBG_EXPECT_TEEC_SUCCESS(c, res);
+
+	while (n)
+		TEEC_CloseSession(sessions + --n);
+}
+
+ZTEST(core_benchmark, test_1007)
+{
+	struct xtest_bench_stats stats = { };
+	TEEC_Session *sessions = NULL;
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("Session capacity");
+
+	sessions = k_calloc(CAP_MAX_SESSIONS, sizeof(*sessions));
+	if (!ADBG_EXPECT_NOT_NULL(&c, sessions) ||
+	    !ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&stats,
+						       CAP_MAX_SESSIONS)))
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(cap_tas); n++) {
+		Do_ADBG_BeginSubCase(&c, "%s", cap_tas[n].name);
+		cap_probe(&c, n, sessions, &stats);
+		Do_ADBG_EndSubCase(&c, "%s", cap_tas[n].name);
+	}
+
+out:
+	xtest_bench_stats_free(&stats);
+	k_free(sessions);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Single instance multi session scaling
+ *
+ * 1, 2, 4 and 8 threads, each with its own session, invoke a short
+ * command SCALE_OPS times concurrently: TA_SIMS_CMD_GET_COUNTER on the
+ * single instance sims_test TA, whose sessions all share one instance
+ * entered by one thread at a time, and TA_CRYPT_CMD_SHA256 of 3 bytes on
+ * the multi instance crypt TA, where every session gets its own
+ * instance. The commands do not cost the same, so each TA is compared
+ * with its own single thread run: the speedup is the aggregate
+ * throughput over the single thread one and the queueing delay is the
+ * mean latency in excess of the single thread mean.
+ */
+#define SCALE_MAX_THREADS	8
+#define SCALE_OPS		256
+#define SCALE_STACK_SIZE	(2048 + CONFIG_TEST_EXTRA_STACK_SIZE)
+
+struct scale_ta {
+	const char *name;
+	const TEEC_UUID *uuid;
+	TEEC_Result (*invoke)(TEEC_Session *sess);
+};
+
+struct scale_arg {
+	const struct scale_ta *ta;
+	TEEC_Session session;
+	TEEC_Result res;
+	uint64_t start_ns;
+	uint64_t end_ns;
+};
+
+static struct k_thread scale_thr[SCALE_MAX_THREADS];
+static struct scale_arg scale_args[SCALE_MAX_THREADS];
+static K_THREAD_STACK_ARRAY_DEFINE(scale_stacks, SCALE_MAX_THREADS,
+				   SCALE_STACK_SIZE);
+
+static struct k_spinlock scale_lock;
+static struct xtest_bench_stats scale_stats;
+
+static TEEC_Result sims_counter_invoke(TEEC_Session *sess)
+{
+	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
+	uint32_t ret_orig = 0;
+
+	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_OUTPUT, TEEC_NONE,
+					 TEEC_NONE, TEEC_NONE);
+
+	return TEEC_InvokeCommand(sess, TA_SIMS_CMD_GET_COUNTER, &op,
+				  &ret_orig);
+}
+
+static TEEC_Result crypt_sha256_invoke(TEEC_Session *sess)
+{
+	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
+	static const uint8_t in[] = { 'a', 'b', 'c' };
+	uint8_t out[32] = { };
+	uint32_t ret_orig = 0;
+
+	op.params[0].tmpref.buffer = (void *)in;
+	op.params[0].tmpref.size = sizeof(in);
+	op.params[1].tmpref.buffer = out;
+	op.params[1].tmpref.size = sizeof(out);
+	op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INPUT,
+					 TEEC_MEMREF_TEMP_OUTPUT,
+					 TEEC_NONE, TEEC_NONE);
+
+	return TEEC_InvokeCommand(sess, TA_CRYPT_CMD_SHA256, &op, &ret_orig);
+}
+
+static const struct scale_ta scale_tas[] = {
+	{ "sims_test", &sims_test_ta_uuid, sims_counter_invoke },
+	{ "crypt", &crypt_user_ta_uuid, crypt_sha256_invoke },
+};
+
+static void scale_thread(void *arg1, void *arg2, void *arg3)
+{
+	struct scale_arg *a = arg1;
+	k_spinlock_key_t key = { };
+	uint64_t t = 0;
+	size_t n = 0;
+
+	a->start_ns = xtest_bench_now_ns();
+	for (n = 0; n < SCALE_OPS; n++) {
+		t = xtest_bench_now_ns();
+		a->res = a->ta->invoke(&a->session);
+		t = xtest_bench_now_ns() - t;
+		if (a->res != TEEC_SUCCESS)
+			break;
+
+		key = k_spin_lock(&scale_lock);
+		xtest_bench_stats_add(&scale_stats, t);
+		k_spin_unlock(&scale_lock, key);
+	}
+	a->end_ns = xtest_bench_now_ns();
+}
+
+/* Aggregate throughput in op/s scaled by 1000, 0 on error */
+static uint64_t scale_run(ADBG_Case_t *c, const struct scale_ta *ta,
+			  size_t nb_threads)
+{
+	uint64_t first_start = UINT64_MAX;
+	uint64_t last_end = 0;
+	uint32_t ret_orig = 0;
+	bool ok = true;
+	k_tid_t tid = NULL;
+	size_t opened = 0;
+	size_t n = 0;
+	size_t i = 0;
+
+	memset(scale_args, 0, sizeof(scale_args));
+	xtest_bench_stats_reset(&scale_stats);
+
+	/* All sessions are open before the first invocation */
+	for (opened = 0; opened < nb_threads; opened++) {
+		scale_args[opened].ta = ta;
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, xtest_teec_open_session(
+				&scale_args[opened].session, ta->uuid, NULL,
+				&ret_orig)))
+			goto out;
+	}
+
+	for (n = 0; n < nb_threads; n++) {
+		tid = k_thread_create(scale_thr + n, scale_stacks[n],
+				      SCALE_STACK_SIZE, scale_thread,
+				      scale_args + n, NULL, NULL,
+				      K_PRIO_PREEMPT(0), K_USER, K_NO_WAIT);
+		if (!ADBG_EXPECT_NOT(c, 0, (long)tid))
+			break;
+	}
+
+	for (i = 0; i < n; i++)
+		ADBG_EXPECT(c, 0, k_thread_join(scale_thr + i, K_FOREVER));
+
+	for (i = 0; i < n; i++) {
+		ok &= ADBG_EXPECT_TEEC_SUCCESS(c, scale_args[i].res);
+		first_start = MIN(first_start, scale_args[i].start_ns);
+		last_end = MAX(last_end, scale_args[i].end_ns);
+	}
+
+out:
+	while (opened)
+		TEEC_CloseSession(&scale_args[--opened].session);
+
+	if (!ok || n != nb_threads)
+		return 0;
+
+	return xtest_bench_rate_milli(scale_stats.count,
+				      last_end - first_start);
+}
+
+static void scale_bench(ADBG_Case_t *c, const struct scale_ta *ta)
+{
+	uint64_t base_rate = 0;
+	uint64_t base_mean = 0;
+	uint64_t rate = 0;
+	uint64_t mean = 0;
+	char label[48] = { };
+	size_t n = 0;
+
+	for (n = 1; n <= SCALE_MAX_THREADS; n *= 2) {
+		rate = scale_run(c, ta, n);
+		if (!rate)
+			return;
+
+		mean = xtest_bench_stats_mean(&scale_stats);
+		if (n == 1) {
+			base_rate = rate;
+			base_mean = mean;
+		}
+
+		snprintk(label, sizeof(label), "%s, %zu threads", ta->name, n);
+		xtest_bench_stats_print(label, &scale_stats);
+		Do_ADBG_Log("    %-40s " XTEST_BENCH_MILLI_FMT
+			    " op/s aggregate, speedup " XTEST_BENCH_MILLI_FMT
+			    ", queueing delay " XTEST_BENCH_US_FMT " us", "",
+			    XTEST_BENCH_MILLI(rate),
+			    XTEST_BENCH_MILLI(rate * 1000 / base_rate),
+			    XTEST_BENCH_US(mean > base_mean ?
+					   mean - base_mean : 0));
+	}
+}
+
+ZTEST(core_benchmark, test_1008)
+{
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("Single instance multi session scaling");
+
+	if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&scale_stats,
+				SCALE_MAX_THREADS * SCALE_OPS))) {
+		ADBG_Assert(&c);
+		return;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(scale_tas); n++)
+		scale_bench(&c, scale_tas + n);
+
+	xtest_bench_stats_free(&scale_stats);
+	ADBG_Assert(&c);
+}
+
+/*
+ * TA to TA invocation overhead
+ *
+ * TA_OS_TEST_CMD_CLIENT makes the os_test TA open a session to the crypt
+ * TA, hash 3 bytes with TA_CRYPT_CMD_SHA256 and close the session. The
+ * same sequence is timed directly from the client, together with the
+ * hash alone on a kept session and TA_OS_TEST_CMD_GET_GLOBAL_VAR on the
+ * same os_test session, used as the cost of the outer client to os_test
+ * call. The TA to TA hop is the nested sequence less the direct one and
+ * the outer call. It is negative when the nested open, invoke and close
+ * cost less than the world switches the direct ones pay.
+ * TA_OS_TEST_CMD_TA2TA_MEMREF, where os_test calls itself with in, out
+ * and inout memrefs on its stack, is timed as well.
+ */
+#define TA2TA_ITERATIONS	32
+
+enum ta2ta_step {
+	TA2TA_OUTER_CALL,
+	TA2TA_DIRECT,
+	TA2TA_DIRECT_KEPT,
+	TA2TA_NESTED,
+	TA2TA_NESTED_MEMREF,
+	TA2TA_STEP_COUNT,
+};
+
+static const char * const ta2ta_labels[TA2TA_STEP_COUNT] = {
+	[TA2TA_OUTER_CALL] = "client -> os_test, short invoke",
+	[TA2TA_DIRECT] = "client -> crypt, open+sha256+close",
+	[TA2TA_DIRECT_KEPT] = "client -> crypt, sha256",
+	[TA2TA_NESTED] = "os_test -> crypt, open+sha256+close",
+	[TA2TA_NESTED_MEMREF] = "os_test -> os_test, memrefs",
+};
+
+struct ta2ta_sessions {
+	TEEC_Session os_test;
+	TEEC_Session crypt;
+};
+
+static TEEC_Result ta2ta_outer_invoke(TEEC_Session *sess)
+{
+	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
+	uint32_t ret_orig = 0;
+
+	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_OUTPUT, TEEC_NONE,
+					 TEEC_NONE, TEEC_NONE);
+
+	return TEEC_InvokeCommand(sess, TA_OS_TEST_CMD_GET_GLOBAL_VAR, &op,
+				  &ret_orig);
+}
+
+static TEEC_Result ta2ta_step(struct ta2ta_sessions *s, enum ta2ta_step step)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session sess = { };
+	uint32_t ret_orig = 0;
+
+	switch (step) {
+	case TA2TA_OUTER_CALL:
+		return ta2ta_outer_invoke(&s->os_test);
+	case TA2TA_DIRECT:
+		res = xtest_teec_open_session(&sess, &crypt_user_ta_uuid, NULL,
+					      &ret_orig);
+		if (res != TEEC_SUCCESS)
+			return res;
+		res = crypt_sha256_invoke(&sess);
+		TEEC_CloseSession(&sess);
+		return res;
+	case TA2TA_DIRECT_KEPT:
+		return crypt_sha256_invoke(&s->crypt);
+	case TA2TA_NESTED:
+		return TEEC_InvokeCommand(&s->os_test, TA_OS_TEST_CMD_CLIENT,
+					  NULL, &ret_orig);
+	default:
+		return TEEC_InvokeCommand(&s->os_test,
+					  TA_OS_TEST_CMD_TA2TA_MEMREF, NULL,
+					  &ret_orig);
+	}
+}
+
+ZTEST(core_benchmark, test_1009)
+{
+	struct xtest_bench_stats stats = { };
+	struct ta2ta_sessions s = { };
+	uint64_t p50[TA2TA_STEP_COUNT] = { };
+	uint64_t direct = 0;
+	uint32_t ret_orig = 0;
+	uint64_t t = 0;
+	size_t step = 0;
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("TA to TA invocation overhead");
+
+	if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&stats,
+						       TA2TA_ITERATIONS))) {
+		ADBG_Assert(&c);
+		return;
+	}
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, xtest_teec_open_session(&s.os_test,
+				&os_test_ta_uuid, NULL, &ret_orig)))
+		goto out;
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, xtest_teec_open_session(&s.crypt,
+				&crypt_user_ta_uuid, NULL, &ret_orig)))
+		goto out_os_test;
+
+	for (step = 0; step < TA2TA_STEP_COUNT; step++) {
+		xtest_bench_stats_reset(&stats);
+
+		for (n = 0; n < TA2TA_ITERATIONS; n++) {
+			t = xtest_bench_now_ns();
+			if (!ADBG_EXPECT_TEEC_SUCCESS(&c, ta2ta_step(&s, step)))
+				goto out_crypt;
+			xtest_bench_stats_add(&stats, xtest_bench_now_ns() - t);
+		}
+
+		p50[step] = xtest_bench_stats_percentile(&stats, 50);
+		xtest_bench_stats_print(ta2ta_labels[step], &stats);
+	}
+
+	/* Medians, signed: the nested sequence saves world switches */
+	direct = p50[TA2TA_DIRECT] + p50[TA2TA_OUTER_CALL];
+	if (p50[TA2TA_NESTED] >= direct)
+		Do_ADBG_Log("    TA to TA hop: +" XTEST_BENCH_US_FMT
+			    " us over the direct sequence",
+			    XTEST_BENCH_US(p50[TA2TA_NESTED] - direct));
+	else
+		Do_ADBG_Log("    TA to TA hop: -" XTEST_BENCH_US_FMT
+			    " us over the direct sequence",
+			    XTEST_BENCH_US(direct - p50[TA2TA_NESTED]));
+
+out_crypt:
+	TEEC_CloseSession(&s.crypt);
+out_os_test:
+	TEEC_CloseSession(&s.os_test);
+out:
+	xtest_bench_stats_free(&stats);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Dynamic library loading cost
+ *
+ * In each of DL_RUNS runs, a session is opened to the statically linked
+ * crypt TA and closed, then a session is opened to the os_test TA, which
+ * is linked against the os_test_lib shared library, and
+ * TA_OS_TEST_CMD_CALL_LIB and TA_OS_TEST_CMD_CALL_LIB_DL (dlopen(),
+ * dlsym(), call and dlclose() of os_test_lib_dl) are invoked DL_REPEATS
+ * times each. The first invocation of each command in a session and the
+ * following ones are reported separately, over all runs.
+ */
+#define DL_RUNS			8
+#define DL_REPEATS		8
+
+enum dl_step {
+	DL_OPEN_STATIC,
+	DL_OPEN_DYNAMIC,
+	DL_LIB_FIRST,
+	DL_LIB_REPEAT,
+	DL_DL_FIRST,
+	DL_DL_REPEAT,
+	DL_STEP_COUNT,
+};
+
+static const char * const dl_labels[DL_STEP_COUNT] = {
+	[DL_OPEN_STATIC] = "open crypt (static)",
+	[DL_OPEN_DYNAMIC] = "open os_test (shared library)",
+	[DL_LIB_FIRST] = "call lib, first in session",
+	[DL_LIB_REPEAT] = "call lib, repeated",
+	[DL_DL_FIRST] = "dlopen+dlsym+call, first in session",
+	[DL_DL_REPEAT] = "dlopen+dlsym+call, repeated",
+};
+
+static TEEC_Result dl_open(TEEC_Session *sess, const TEEC_UUID *uuid,
+			   struct xtest_bench_stats *stats)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint32_t ret_orig = 0;
+	uint64_t t = xtest_bench_now_ns();
+
+	res = xtest_teec_open_session(sess, uuid, NULL, &ret_orig);
+	if (res == TEEC_SUCCESS)
+		xtest_bench_stats_add(stats, xtest_bench_now_ns() - t);
+
+	return res;
+}
+
+/* First invocation of @cmd goes to @first, the following to @repeat */
+static TEEC_Result dl_invoke(TEEC_Session *sess, uint32_t cmd,
+			     struct xtest_bench_stats *first,
+			     struct xtest_bench_stats *repeat)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint32_t ret_orig = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	for (n = 0; n < DL_REPEATS; n++) {
+		t = xtest_bench_now_ns();
+		res = TEEC_InvokeCommand(sess, cmd, NULL, &ret_orig);
+		t = xtest_bench_now_ns() - t;
+		if (res != TEEC_SUCCESS)
+			return res;
+
+		xtest_bench_stats_add(n ? repeat : first, t);
+	}
+
+	return TEEC_SUCCESS;
+}
+
+static bool dl_run(ADBG_Case_t *c, struct xtest_bench_stats *stats)
+{
+	TEEC_Session sess = { };
+	bool ok = false;
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, dl_open(&sess, &crypt_user_ta_uuid,
+						 stats + DL_OPEN_STATIC)))
+		return false;
+	TEEC_CloseSession(&sess);
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, dl_open(&sess, &os_test_ta_uuid,
+						 stats + DL_OPEN_DYNAMIC)))
+		return false;
+
+	ok = ADBG_EXPECT_TEEC_SUCCESS(c, dl_invoke(&sess,
+					TA_OS_TEST_CMD_CALL_LIB,
+					stats + DL_LIB_FIRST,
+					stats + DL_LIB_REPEAT)) &&
+	     ADBG_EXPECT_TEEC_SUCCESS(c, dl_invoke(&sess,
+					TA_OS_TEST_CMD_CALL_LIB_DL,
+					stats + DL_DL_FIRST,
+					stats + DL_DL_REPEAT));
+
+	TEEC_CloseSession(&sess);
+
+	return ok;
+}
+
+ZTEST(core_benchmark, test_1010)
+{
+	struct xtest_bench_stats stats[DL_STEP_COUNT] = { };
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("Dynamic library loading cost");
+
+	for (n = 0; n < DL_STEP_COUNT; n++) {
+		if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(stats + n,
+						DL_RUNS * DL_REPEATS)))
+			goto out;
+	}
+
+	Do_ADBG_Log("    crypt %zu bytes binary, os_test %zu bytes binary",
+		    ta_binary_size(&crypt_user_ta_uuid),
+		    ta_binary_size(&os_test_ta_uuid));
+
+	for (n = 0; n < DL_RUNS; n++) {
+		if (!dl_run(&c, stats))
+			goto out;
+	}
+
+	for (n = 0; n < DL_STEP_COUNT; n++)
+		xtest_bench_stats_print(dl_labels[n], stats + n);
+
+out:
+	for (n = 0; n < DL_STEP_COUNT; n++)
+		xtest_bench_stats_free(stats + n);
+	ADBG_Assert(&c);
+}
+
+ZTEST_SUITE(core_benchmark, NULL, core_benchmark_init, NULL, NULL,
+	    core_benchmark_deinit);
@@ -0,0 +1,2031 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <ck_debug.h>
+#include <inttypes.h>
+#include <pkcs11.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "optee_test.h"
+#include "pkcs11_helpers.h"
+#include "xtest_benchmark.h"
+#include "xtest_helpers.h"
+
+/*
+ * Some PKCS#11 object resources used in the benchmarks
+ */
+static const CK_BYTE cktest_aes128_iv[16];
+
+static CK_MECHANISM cktest_aes_ecb_mechanism = {
+	CKM_AES_ECB,
+	NULL, 0,
+};
+static CK_MECHANISM cktest_aes_cbc_mechanism = {
+	CKM_AES_CBC,
+	(CK_BYTE_PTR)cktest_aes128_iv, sizeof(cktest_aes128_iv),
+};
+/* RFC 3394 and RFC 5649, with the default initial value */
+static CK_MECHANISM cktest_aes_key_wrap_mechanism = {
+	CKM_AES_KEY_WRAP,
+	NULL, 0,
+};
+static CK_MECHANISM cktest_aes_key_wrap_pad_mechanism = {
+	CKM_AES_KEY_WRAP_PAD,
+	NULL, 0,
+};
+
+static const CK_AES_CTR_PARAMS cktest_aes_ctr_params = {
+	.ulCounterBits = 32,
+};
+
+static CK_MECHANISM cktest_gensecret_keygen_mechanism = {
+	CKM_GENERIC_SECRET_KEY_GEN, NULL, 0,
+};
+static CK_MECHANISM cktest_aes_keygen_mechanism = {
+	CKM_AES_KEY_GEN, NULL, 0,
+};
+
+/**
+ *    0:d=0  hl=2 l=   8 prim: OBJECT            :prime256v1
+ */
+static uint8_t ecdsa_nist_p256[] = {
+	0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03,
+	0x01, 0x07
+};
+
+/**
+ *    0:d=0  hl=2 l=   5 prim: OBJECT            :secp384r1
+ */
+static uint8_t ecdsa_nist_p384[] = {
+	0x06, 0x05, 0x2b, 0x81, 0x04, 0x00, 0x22
+};
+
+/**
+ *    0:d=0  hl=2 l=   5 prim: OBJECT            :secp521r1
+ */
+static uint8_t ecdsa_nist_p521[] = {
+	0x06, 0x05, 0x2b, 0x81, 0x04, 0x00, 0x23
+};
+
+/**
+ *    0:d=0  hl=2 l=  22 cons: SEQUENCE
+ *    2:d=1  hl=2 l=  20 cons:  SET
+ *    4:d=2  hl=2 l=  18 cons:   SEQUENCE
+ *    6:d=3  hl=2 l=   3 prim:    OBJECT            :commonName
+ *   11:d=3  hl=2 l=  11 prim:    UTF8STRING        :common name
+ */
+static uint8_t subject_common_name[] = {
+	0x30, 0x16, 0x31, 0x14, 0x30, 0x12, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0c,
+	0x0b, 0x63, 0x6f, 0x6d, 0x6d, 0x6f, 0x6e, 0x20, 0x6e, 0x61, 0x6d, 0x65
+};
+
+static CK_BYTE rsa_public_exponent[] = { 0x01, 0x00, 0x01 };
+
+extern TEEC_Context xtest_teec_ctx;
+
+void *pkcs11_benchmark_init(void)
+{
+	printk("Begin Test suite pkcs11_benchmark\n");
+	(void)TEEC_InitializeContext(NULL, &xtest_teec_ctx);
+	return NULL;
+}
+
+void pkcs11_benchmark_deinit(void *param)
+{
+	(void)param;
+	printk("End Test suite pkcs11_benchmark\n");
+	TEEC_FinalizeContext(&xtest_teec_ctx);
+}
+
+/* Check that the token supports @type with all of @flags set */
+static bool mechanism_is_supported(CK_SLOT_ID slot, CK_MECHANISM_TYPE type,
+				   CK_FLAGS flags)
+{
+	CK_MECHANISM_INFO info = { };
+
+	if (C_GetMechanismInfo(slot, type, &info) != CKR_OK)
+		return false;
+
+	return (info.flags & flags) == flags;
+}
+
+/*
+ * Key wrap/unwrap throughput
+ *
+ * A batch of extractable keys is generated, then every key is wrapped and
+ * the wrapped blobs are unwrapped back into session objects. Each
+ * C_WrapKey()/C_UnwrapKey() call is timed individually. Mechanisms the
+ * token does not report with CKF_WRAP and CKF_UNWRAP are skipped.
+ */
+#define WRAP_BENCH_BATCH		64
+/*
+ * Largest target key (64 bytes) plus one block of padding, more than the
+ * 8 bytes of integrity check the key wrap mechanisms add
+ */
+#define WRAP_BENCH_WRAPPED_MAX_SIZE	80
+
+static const struct {
+	const char *name;
+	CK_MECHANISM_PTR mecha;
+} wrap_bench_mechas[] = {
+	{ "CKM_AES_ECB", &cktest_aes_ecb_mechanism },
+	{ "CKM_AES_CBC", &cktest_aes_cbc_mechanism },
+	{ "CKM_AES_KEY_WRAP", &cktest_aes_key_wrap_mechanism },
+	{ "CKM_AES_KEY_WRAP_PAD", &cktest_aes_key_wrap_pad_mechanism },
+};
+
+static const CK_ULONG wrap_bench_wrapping_key_sizes[] = { 16, 32 };
+
+static const struct {
+	const char *name;
+	CK_KEY_TYPE key_type;
+	CK_MECHANISM_PTR keygen;
+	CK_ULONG key_size;
+} wrap_bench_keys[] = {
+	{ "AES-128", CKK_AES, &cktest_aes_keygen_mechanism, 16 },
+	{ "AES-192", CKK_AES, &cktest_aes_keygen_mechanism, 24 },
+	{ "AES-256", CKK_AES, &cktest_aes_keygen_mechanism, 32 },
+	{ "GENERIC-128", CKK_GENERIC_SECRET,
+	  &cktest_gensecret_keygen_mechanism, 16 },
+	{ "GENERIC-256", CKK_GENERIC_SECRET,
+	  &cktest_gensecret_keygen_mechanism, 32 },
+	{ "GENERIC-384", CKK_GENERIC_SECRET,
+	  &cktest_gensecret_keygen_mechanism, 48 },
+	{ "GENERIC-512", CKK_GENERIC_SECRET,
+	  &cktest_gensecret_keygen_mechanism, 64 },
+};
+
+static void wrap_unwrap_batch(ADBG_Case_t *c, CK_SESSION_HANDLE session,
+			      CK_MECHANISM_PTR mecha,
+			      CK_OBJECT_HANDLE wrapping_key, size_t idx)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_KEY_TYPE key_type = wrap_bench_keys[idx].key_type;
+	CK_ULONG key_size = wrap_bench_keys[idx].key_size;
+	CK_OBJECT_CLASS key_class = CKO_SECRET_KEY;
+	CK_ATTRIBUTE key_template[] = {
+		{ CKA_VALUE_LEN, &key_size, sizeof(key_size) },
+		{ CKA_EXTRACTABLE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+	CK_ATTRIBUTE unwrap_template[] = {
+		{ CKA_CLASS, &key_class, sizeof(key_class) },
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_VALUE_LEN, &key_size, sizeof(key_size) },
+		{ CKA_EXTRACTABLE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+	CK_OBJECT_HANDLE keys[WRAP_BENCH_BATCH] = { };
+	CK_ULONG wrapped_len[WRAP_BENCH_BATCH] = { };
+	CK_OBJECT_HANDLE unwrapped_key = CK_INVALID_HANDLE;
+	struct xtest_bench_stats wrap_stats = { };
+	struct xtest_bench_stats unwrap_stats = { };
+	uint8_t *wrapped = NULL;
+	char label[48] = { };
+	uint64_t t = 0;
+	size_t nb_keys = 0;
+	size_t n = 0;
+
+	wrapped = k_malloc(WRAP_BENCH_BATCH * WRAP_BENCH_WRAPPED_MAX_SIZE);
+	if (!ADBG_EXPECT_NOT_NULL(c, wrapped))
+		return;
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&wrap_stats,
+						      WRAP_BENCH_BATCH)) ||
+	    !ADBG_EXPECT(c, 0, xtest_bench_stats_init(&unwrap_stats,
+						      WRAP_BENCH_BATCH)))
+		goto out;
+
+	for (nb_keys = 0; nb_keys < WRAP_BENCH_BATCH; nb_keys++) {
+		rv = C_GenerateKey(session, wrap_bench_keys[idx].keygen,
+				   key_template, ARRAY_SIZE(key_template),
+				   keys + nb_keys);
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+	}
+
+	for (n = 0; n < nb_keys; n++) {
+		wrapped_len[n] = WRAP_BENCH_WRAPPED_MAX_SIZE;
+
+		t = xtest_bench_now_ns();
+		rv = C_WrapKey(session, mecha, wrapping_key, keys[n],
+			       wrapped + n * WRAP_BENCH_WRAPPED_MAX_SIZE,
+			       wrapped_len + n);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+
+		xtest_bench_stats_add(&wrap_stats, t);
+	}
+
+	for (n = 0; n < nb_keys; n++) {
+		t = xtest_bench_now_ns();
+		rv = C_UnwrapKey(session, mecha, wrapping_key,
+				 wrapped + n * WRAP_BENCH_WRAPPED_MAX_SIZE,
+				 wrapped_len[n], unwrap_template,
+				 ARRAY_SIZE(unwrap_template), &unwrapped_key);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+
+		xtest_bench_stats_add(&unwrap_stats, t);
+
+		rv = C_DestroyObject(session, unwrapped_key);
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+	}
+
+	snprintf(label, sizeof(label), "%s wrap (%lu bytes out)",
+		 wrap_bench_keys[idx].name, wrapped_len[0]);
+	xtest_bench_stats_print(label, &wrap_stats);
+	snprintf(label, sizeof(label), "%s unwrap",
+		 wrap_bench_keys[idx].name);
+	xtest_bench_stats_print(label, &unwrap_stats);
+
+out:
+	for (n = 0; n < nb_keys; n++)
+		ADBG_EXPECT_CK_OK(c, C_DestroyObject(session, keys[n]));
+
+	xtest_bench_stats_free(&unwrap_stats);
+	xtest_bench_stats_free(&wrap_stats);
+	k_free(wrapped);
+}
+
+static void xtest_pkcs11_benchmark_1001(ADBG_Case_t *c)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_SLOT_ID slot = 0;
+	CK_SESSION_HANDLE session = CK_INVALID_HANDLE;
+	CK_FLAGS session_flags = CKF_SERIAL_SESSION | CKF_RW_SESSION;
+	CK_OBJECT_HANDLE wrapping_key = CK_INVALID_HANDLE;
+	CK_ULONG wrapping_key_size = 0;
+	CK_ATTRIBUTE wrapping_key_template[] = {
+		{ CKA_VALUE_LEN, &wrapping_key_size, sizeof(CK_ULONG) },
+		{ CKA_WRAP, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_UNWRAP, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_SENSITIVE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_EXTRACTABLE, &(CK_BBOOL){ CK_FALSE }, sizeof(CK_BBOOL) },
+	};
+	size_t m = 0;
+	size_t w = 0;
+	size_t k = 0;
+
+	rv = init_lib_and_find_token_slot(&slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		return;
+
+	rv = init_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = init_user_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = C_OpenSession(slot, session_flags, NULL, 0, &session);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	Do_ADBG_Log("    batch of %d keys per measurement", WRAP_BENCH_BATCH);
+
+	for (m = 0; m < ARRAY_SIZE(wrap_bench_mechas); m++) {
+		CK_MECHANISM_PTR mecha = wrap_bench_mechas[m].mecha;
+
+		if (!mechanism_is_supported(slot, mecha->mechanism,
+					    CKF_WRAP | CKF_UNWRAP)) {
+			Do_ADBG_Log("    %s: no wrap/unwrap support, skipped",
+				    wrap_bench_mechas[m].name);
+			continue;
+		}
+
+		for (w = 0; w < ARRAY_SIZE(wrap_bench_wrapping_key_sizes);
+		     w++) {
+			wrapping_key_size = wrap_bench_wrapping_key_sizes[w];
+
+			Do_ADBG_BeginSubCase(c, "%s, AES-%lu wrapping key",
+					     wrap_bench_mechas[m].name,
+					     wrapping_key_size * 8);
+
+			rv = C_GenerateKey(session,
+					   &cktest_aes_keygen_mechanism,
+					   wrapping_key_template,
+					   ARRAY_SIZE(wrapping_key_template),
+					   &wrapping_key);
+			if (!ADBG_EXPECT_CK_OK(c, rv))
+				goto close_session;
+
+			for (k = 0; k < ARRAY_SIZE(wrap_bench_keys); k++)
+				wrap_unwrap_batch(c, session, mecha,
+						  wrapping_key, k);
+
+			rv = C_DestroyObject(session, wrapping_key);
+			if (!ADBG_EXPECT_CK_OK(c, rv))
+				goto close_session;
+
+			Do_ADBG_EndSubCase(c, "%s, AES-%lu wrapping key",
+					   wrap_bench_mechas[m].name,
+					   wrapping_key_size * 8);
+		}
+	}
+
+close_session:
+	ADBG_EXPECT_CK_OK(c, C_CloseSession(session));
+close_lib:
+	ADBG_EXPECT_CK_OK(c, close_lib());
+}
+
+ZTEST(pkcs11_benchmark, test_1001)
+{
+	ADBG_STRUCT_DECLARE("PKCS11: Key wrap/unwrap throughput");
+
+	xtest_pkcs11_benchmark_1001(&c);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Mechanism sweep
+ *
+ * Every mechanism reported by C_GetMechanismList() is listed with its
+ * C_GetMechanismInfo() capabilities and then timed for each key size picked
+ * in the advertised ulMinKeySize..ulMaxKeySize range. The range is in bits
+ * for EC and RSA mechanisms and for CKM_GENERIC_SECRET_KEY_GEN, in bytes for
+ * the other secret key mechanisms (AES, HMAC); it is converted to the unit
+ * of the key size attribute, bytes for CKA_VALUE_LEN.
+ *
+ * The operation run is derived from the CK_MECHANISM_INFO flags: a digest,
+ * a signature or an encryption with a NULL mechanism parameter, or a key
+ * (pair) generation. The key type is found by trying each key type this
+ * test can generate, in the advertised size range, until the token accepts
+ * one. Signatures and encryptions with an EC or RSA key use a digest sized
+ * input so that the raw mechanisms are covered as well. Only mechanisms
+ * needing a parameter are described in the table below.
+ */
+#define SWEEP_ITERATIONS		32
+#define SWEEP_KEYPAIR_ITERATIONS	4
+#define SWEEP_DATA_SIZE			1024
+/* Digest size, used as input of the EC and RSA mechanisms */
+#define SWEEP_HASH_SIZE			32
+#define SWEEP_MAX_KEY_SIZES		12
+
+enum sweep_op {
+	SWEEP_OP_NONE,
+	SWEEP_OP_DIGEST,
+	SWEEP_OP_ENCRYPT,
+	SWEEP_OP_SIGN,
+	SWEEP_OP_GENERATE,
+	SWEEP_OP_GENERATE_PAIR,
+};
+
+struct sweep_profile {
+	CK_MECHANISM_TYPE type;
+	enum sweep_op op;
+	/* Key type is found by sweep_probe_key_type(), unused for digests */
+	bool probe_key_type;
+	CK_KEY_TYPE key_type;
+	/* Input data size, 0 for SWEEP_DATA_SIZE */
+	CK_ULONG data_size;
+	CK_VOID_PTR param;
+	CK_ULONG param_len;
+};
+
+static const struct sweep_profile sweep_profiles[] = {
+	{ .type = CKM_AES_CBC, .op = SWEEP_OP_ENCRYPT, .key_type = CKK_AES,
+	  .param = (CK_VOID_PTR)cktest_aes128_iv,
+	  .param_len = sizeof(cktest_aes128_iv) },
+	{ .type = CKM_AES_CBC_PAD, .op = SWEEP_OP_ENCRYPT, .key_type = CKK_AES,
+	  .param = (CK_VOID_PTR)cktest_aes128_iv,
+	  .param_len = sizeof(cktest_aes128_iv) },
+	{ .type = CKM_AES_CTS, .op = SWEEP_OP_ENCRYPT, .key_type = CKK_AES,
+	  .param = (CK_VOID_PTR)cktest_aes128_iv,
+	  .param_len = sizeof(cktest_aes128_iv) },
+	{ .type = CKM_AES_CTR, .op = SWEEP_OP_ENCRYPT, .key_type = CKK_AES,
+	  .param = (CK_VOID_PTR)&cktest_aes_ctr_params,
+	  .param_len = sizeof(cktest_aes_ctr_params) },
+};
+
+/* Operation run for a mechanism without profile, by priority */
+static const struct {
+	CK_FLAGS flag;
+	enum sweep_op op;
+} sweep_flag_ops[] = {
+	{ CKF_DIGEST, SWEEP_OP_DIGEST },
+	{ CKF_SIGN, SWEEP_OP_SIGN },
+	{ CKF_ENCRYPT, SWEEP_OP_ENCRYPT },
+	{ CKF_GENERATE, SWEEP_OP_GENERATE },
+	{ CKF_GENERATE_KEY_PAIR, SWEEP_OP_GENERATE_PAIR },
+};
+
+static const struct {
+	CK_FLAGS flag;
+	const char *name;
+} sweep_flag_names[] = {
+	{ CKF_ENCRYPT, "enc" },
+	{ CKF_DECRYPT, "dec" },
+	{ CKF_DIGEST, "digest" },
+	{ CKF_SIGN, "sign" },
+	{ CKF_VERIFY, "verify" },
+	{ CKF_GENERATE, "gen" },
+	{ CKF_GENERATE_KEY_PAIR, "genpair" },
+	{ CKF_WRAP, "wrap" },
+	{ CKF_UNWRAP, "unwrap" },
+	{ CKF_DERIVE, "derive" },
+};
+
+/* Key types tried, in order, for a mechanism without profile */
+static const CK_KEY_TYPE sweep_key_types[] = {
+	CKK_AES, CKK_GENERIC_SECRET, CKK_EC, CKK_RSA,
+};
+
+static const CK_ULONG sweep_aes_sizes[] = { 16, 24, 32 };
+static const CK_ULONG sweep_ec_sizes[] = { 256, 384, 521 };
+static const CK_ULONG sweep_rsa_sizes[] = { 1024, 2048, 3072, 4096 };
+
+static uint8_t sweep_in[SWEEP_DATA_SIZE];
+/* Room for a 4096 bit RSA signature or one extra padding block */
+static uint8_t sweep_out[SWEEP_DATA_SIZE + 512];
+
+/*
+ * Fill @profile for mechanism @type: the table entry if any, else the
+ * operation derived from @info flags. Return false if nothing can be run.
+ */
+static bool sweep_get_profile(CK_MECHANISM_TYPE type, CK_MECHANISM_INFO *info,
+			      struct sweep_profile *profile)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(sweep_profiles); n++) {
+		if (sweep_profiles[n].type == type) {
+			*profile = sweep_profiles[n];
+			return true;
+		}
+	}
+
+	*profile = (struct sweep_profile){ .type = type };
+	for (n = 0; n < ARRAY_SIZE(sweep_flag_ops); n++) {
+		if (info->flags & sweep_flag_ops[n].flag) {
+			profile->op = sweep_flag_ops[n].op;
+			profile->probe_key_type = true;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool sweep_is_key_pair(CK_KEY_TYPE key_type)
+{
+	return key_type == CKK_EC || key_type == CKK_RSA;
+}
+
+static void sweep_flags_str(CK_FLAGS flags, char *buf, size_t len)
+{
+	size_t pos = 0;
+	size_t n = 0;
+
+	buf[0] = '\0';
+	for (n = 0; n < ARRAY_SIZE(sweep_flag_names) && pos < len; n++) {
+		if (!(flags & sweep_flag_names[n].flag))
+			continue;
+
+		pos += snprintf(buf + pos, len - pos, "%s%s", pos ? "|" : "",
+				sweep_flag_names[n].name);
+	}
+}
+
+static size_t sweep_pick_sizes(const CK_ULONG *candidates, size_t count,
+			       CK_ULONG min, CK_ULONG max, CK_ULONG *sizes)
+{
+	size_t nb = 0;
+	size_t n = 0;
+
+	for (n = 0; n < count; n++)
+		if (candidates[n] >= min && candidates[n] <= max)
+			sizes[nb++] = candidates[n];
+
+	return nb;
+}
+
+/*
+ * Fill @sizes with the key sizes to benchmark for mechanism @type: the
+ * sizes the key type defines within the advertised range, or for generic
+ * secrets the minimum, every power of two in between and the maximum.
+ */
+static size_t sweep_key_sizes(CK_MECHANISM_TYPE type, CK_KEY_TYPE key_type,
+			      CK_MECHANISM_INFO *info, CK_ULONG *sizes)
+{
+	CK_ULONG min = info->ulMinKeySize;
+	CK_ULONG max = info->ulMaxKeySize;
+	CK_ULONG size = 0;
+	size_t nb = 0;
+
+	/* Reported in bits, CKA_VALUE_LEN is in bytes */
+	if (type == CKM_GENERIC_SECRET_KEY_GEN) {
+		min = DIV_ROUND_UP(min, 8);
+		max /= 8;
+	}
+
+	switch (key_type) {
+	case CKK_AES:
+		return sweep_pick_sizes(sweep_aes_sizes,
+					ARRAY_SIZE(sweep_aes_sizes), min, max,
+					sizes);
+	case CKK_EC:
+		return sweep_pick_sizes(sweep_ec_sizes,
+					ARRAY_SIZE(sweep_ec_sizes), min, max,
+					sizes);
+	case CKK_RSA:
+		return sweep_pick_sizes(sweep_rsa_sizes,
+					ARRAY_SIZE(sweep_rsa_sizes), min, max,
+					sizes);
+	case CKK_GENERIC_SECRET:
+		if (!max || min > max)
+			return 0;
+		size = MAX(min, 1UL);
+		sizes[nb++] = size;
+		for (size = 1; size <= max / 2; size *= 2) {
+			if (size <= min)
+				continue;
+			if (nb == SWEEP_MAX_KEY_SIZES - 1)
+				break;
+			sizes[nb++] = size;
+		}
+		if (max > sizes[nb - 1])
+			sizes[nb++] = max;
+		return nb;
+	default:
+		return 0;
+	}
+}
+
+/* Key generation mechanism for the keys used by encryptions and signatures */
+static CK_MECHANISM_TYPE sweep_keygen_mechanism(CK_KEY_TYPE key_type)
+{
+	switch (key_type) {
+	case CKK_AES:
+		return CKM_AES_KEY_GEN;
+	case CKK_EC:
+		return CKM_EC_KEY_PAIR_GEN;
+	case CKK_RSA:
+		return CKM_RSA_PKCS_KEY_PAIR_GEN;
+	default:
+		return CKM_GENERIC_SECRET_KEY_GEN;
+	}
+}
+
+/* Generate a @key_type key of @size with mechanism @keygen */
+static CK_RV sweep_gen_key(CK_SESSION_HANDLE session, CK_MECHANISM_TYPE keygen,
+			   CK_KEY_TYPE key_type, CK_ULONG size,
+			   CK_OBJECT_HANDLE *pub, CK_OBJECT_HANDLE *priv)
+{
+	CK_MECHANISM mecha = { .mechanism = keygen };
+	CK_ULONG value_len = size;
+	CK_ULONG modulus_bits = size;
+	CK_ATTRIBUTE secret_template[] = {
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_VALUE_LEN, &value_len, sizeof(value_len) },
+		{ CKA_ENCRYPT, &(CK_BBOOL){ key_type == CKK_AES },
+		  sizeof(CK_BBOOL) },
+		{ CKA_SIGN, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+	CK_ATTRIBUTE ec_public_template[] = {
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_VERIFY, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_EC_PARAMS, NULL, 0 },
+	};
+	CK_ATTRIBUTE rsa_public_template[] = {
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_VERIFY, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_ENCRYPT, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_MODULUS_BITS, &modulus_bits, sizeof(modulus_bits) },
+		{ CKA_PUBLIC_EXPONENT, rsa_public_exponent,
+		  sizeof(rsa_public_exponent) },
+	};
+	CK_ATTRIBUTE private_template[] = {
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_SIGN, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+
+	*pub = CK_INVALID_HANDLE;
+	*priv = CK_INVALID_HANDLE;
+
+	switch (key_type) {
+	case CKK_AES:
+	case CKK_GENERIC_SECRET:
+		return C_GenerateKey(session, &mecha, secret_template,
+				     ARRAY_SIZE(secret_template), priv);
+	case CKK_EC:
+		switch (size) {
+		case 256:
+			ec_public_template[2].pValue = ecdsa_nist_p256;
+			ec_public_template[2].ulValueLen =
+				sizeof(ecdsa_nist_p256);
+			break;
+		case 384:
+			ec_public_template[2].pValue = ecdsa_nist_p384;
+			ec_public_template[2].ulValueLen =
+				sizeof(ecdsa_nist_p384);
+			break;
+		case 521:
+			ec_public_template[2].pValue = ecdsa_nist_p521;
+			ec_public_template[2].ulValueLen =
+				sizeof(ecdsa_nist_p521);
+			break;
+		default:
+			return CKR_KEY_SIZE_RANGE;
+		}
+		return C_GenerateKeyPair(session, &mecha, ec_public_template,
+					 ARRAY_SIZE(ec_public_template),
+					 private_template,
+					 ARRAY_SIZE(private_template),
+					 pub, priv);
+	case CKK_RSA:
+		return C_GenerateKeyPair(session, &mecha, rsa_public_template,
+					 ARRAY_SIZE(rsa_public_template),
+					 private_template,
+					 ARRAY_SIZE(private_template),
+					 pub, priv);
+	default:
+		return CKR_KEY_TYPE_INCONSISTENT;
+	}
+}
+
+static CK_RV sweep_destroy_key(CK_SESSION_HANDLE session,
+			       CK_OBJECT_HANDLE pub, CK_OBJECT_HANDLE priv)
+{
+	CK_RV rv = CKR_OK;
+
+	if (pub != CK_INVALID_HANDLE)
+		rv = C_DestroyObject(session, pub);
+	if (priv != CK_INVALID_HANDLE && rv == CKR_OK)
+		rv = C_DestroyObject(session, priv);
+
+	return rv;
+}
+
+/* Generate the key @profile operates on, if any */
+static CK_RV sweep_setup_key(CK_SESSION_HANDLE session,
+			     const struct sweep_profile *profile,
+			     CK_ULONG key_size, CK_OBJECT_HANDLE *pub,
+			     CK_OBJECT_HANDLE *priv)
+{
+	*pub = CK_INVALID_HANDLE;
+	*priv = CK_INVALID_HANDLE;
+
+	if (profile->op != SWEEP_OP_ENCRYPT && profile->op != SWEEP_OP_SIGN)
+		return CKR_OK;
+
+	return sweep_gen_key(session,
+			     sweep_keygen_mechanism(profile->key_type),
+			     profile->key_type, key_size, pub, priv);
+}
+
+/* Run and time one iteration of @profile */
+static CK_RV sweep_run_once(CK_SESSION_HANDLE session,
+			    const struct sweep_profile *profile,
+			    CK_ULONG key_size, CK_OBJECT_HANDLE pub,
+			    CK_OBJECT_HANDLE priv, CK_ULONG data_size,
+			    uint64_t *ns)
+{
+	CK_MECHANISM mecha = {
+		profile->type, profile->param, profile->param_len,
+	};
+	CK_OBJECT_HANDLE gen_pub = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE gen_priv = CK_INVALID_HANDLE;
+	CK_ULONG out_len = sizeof(sweep_out);
+	CK_RV rv = CKR_GENERAL_ERROR;
+	uint64_t t = xtest_bench_now_ns();
+
+	switch (profile->op) {
+	case SWEEP_OP_DIGEST:
+		rv = C_DigestInit(session, &mecha);
+		if (rv == CKR_OK)
+			rv = C_Digest(session, sweep_in, data_size, sweep_out,
+				      &out_len);
+		break;
+	case SWEEP_OP_ENCRYPT:
+		/* Key pairs encrypt with the public key */
+		rv = C_EncryptInit(session, &mecha,
+				   pub != CK_INVALID_HANDLE ? pub : priv);
+		if (rv == CKR_OK)
+			rv = C_Encrypt(session, sweep_in, data_size,
+				       sweep_out, &out_len);
+		break;
+	case SWEEP_OP_SIGN:
+		rv = C_SignInit(session, &mecha, priv);
+		if (rv == CKR_OK)
+			rv = C_Sign(session, sweep_in, data_size, sweep_out,
+				    &out_len);
+		break;
+	case SWEEP_OP_GENERATE:
+	case SWEEP_OP_GENERATE_PAIR:
+		rv = sweep_gen_key(session, profile->type, profile->key_type,
+				   key_size, &gen_pub, &gen_priv);
+		*ns = xtest_bench_now_ns() - t;
+		if (rv == CKR_OK)
+			rv = sweep_destroy_key(session, gen_pub, gen_priv);
+		return rv;
+	default:
+		return CKR_MECHANISM_INVALID;
+	}
+
+	*ns = xtest_bench_now_ns() - t;
+
+	return rv;
+}
+
+/*
+ * Find a key type the token accepts for @profile with a NULL mechanism
+ * parameter: run the operation once on the smallest key size of each
+ * candidate key type. Return false if none is accepted.
+ */
+static bool sweep_probe_key_type(CK_SESSION_HANDLE session,
+				 struct sweep_profile *profile,
+				 CK_MECHANISM_INFO *info)
+{
+	CK_OBJECT_HANDLE pub = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE priv = CK_INVALID_HANDLE;
+	CK_ULONG sizes[SWEEP_MAX_KEY_SIZES] = { };
+	CK_RV rv = CKR_GENERAL_ERROR;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(sweep_key_types); n++) {
+		profile->key_type = sweep_key_types[n];
+
+		if (profile->op == SWEEP_OP_GENERATE &&
+		    sweep_is_key_pair(profile->key_type))
+			continue;
+		if (profile->op == SWEEP_OP_GENERATE_PAIR &&
+		    !sweep_is_key_pair(profile->key_type))
+			continue;
+		if (!sweep_key_sizes(profile->type, profile->key_type, info,
+				     sizes))
+			continue;
+
+		profile->data_size = 0;
+		if (sweep_is_key_pair(profile->key_type))
+			profile->data_size = SWEEP_HASH_SIZE;
+
+		rv = sweep_setup_key(session, profile, sizes[0], &pub, &priv);
+		if (rv != CKR_OK)
+			continue;
+
+		rv = sweep_run_once(session, profile, sizes[0], pub, priv,
+				    SWEEP_HASH_SIZE, &t);
+		sweep_destroy_key(session, pub, priv);
+		if (rv == CKR_OK)
+			return true;
+	}
+
+	return false;
+}
+
+static void sweep_mechanism(ADBG_Case_t *c, CK_SESSION_HANDLE session,
+			    struct sweep_profile *profile,
+			    CK_MECHANISM_INFO *info)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_ULONG sizes[SWEEP_MAX_KEY_SIZES] = { };
+	CK_ULONG data_size = 0;
+	CK_OBJECT_HANDLE pub = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE priv = CK_INVALID_HANDLE;
+	struct xtest_bench_stats stats = { };
+	size_t iterations = SWEEP_ITERATIONS;
+	size_t nb_sizes = 0;
+	char label[64] = { };
+	uint64_t t = 0;
+	size_t s = 0;
+	size_t n = 0;
+
+	if (profile->probe_key_type && profile->op != SWEEP_OP_DIGEST &&
+	    !sweep_probe_key_type(session, profile, info)) {
+		Do_ADBG_Log("    %s: no key type accepted with a NULL parameter, skipped",
+			    ckm2str(profile->type));
+		return;
+	}
+
+	data_size = profile->data_size ? profile->data_size : SWEEP_DATA_SIZE;
+
+	if (profile->op == SWEEP_OP_GENERATE_PAIR ||
+	    (profile->op != SWEEP_OP_DIGEST &&
+	     profile->key_type == CKK_RSA))
+		iterations = SWEEP_KEYPAIR_ITERATIONS;
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&stats, iterations)))
+		return;
+
+	/* Digests are keyless: a single run, no key size */
+	if (profile->op == SWEEP_OP_DIGEST)
+		nb_sizes = 1;
+	else
+		nb_sizes = sweep_key_sizes(profile->type, profile->key_type,
+					   info, sizes);
+	if (!nb_sizes)
+		Do_ADBG_Log("    %s: no key size in range %lu..%lu, skipped",
+			    ckm2str(profile->type), info->ulMinKeySize,
+			    info->ulMaxKeySize);
+
+	for (s = 0; s < nb_sizes; s++) {
+		xtest_bench_stats_reset(&stats);
+
+		rv = sweep_setup_key(session, profile, sizes[s], &pub, &priv);
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			break;
+
+		for (n = 0; n < iterations; n++) {
+			rv = sweep_run_once(session, profile, sizes[s], pub,
+					    priv, data_size, &t);
+			if (!ADBG_EXPECT_CK_OK(c, rv))
+				break;
+
+			xtest_bench_stats_add(&stats, t);
+		}
+
+		rv = sweep_destroy_key(session, pub, priv);
+		ADBG_EXPECT_CK_OK(c, rv);
+		pub = CK_INVALID_HANDLE;
+		priv = CK_INVALID_HANDLE;
+
+		if (n < iterations)
+			break;
+
+		if (profile->op == SWEEP_OP_GENERATE ||
+		    profile->op == SWEEP_OP_GENERATE_PAIR)
+			snprintf(label, sizeof(label), "%s key %lu",
+				 ckm2str(profile->type), sizes[s]);
+		else if (profile->op == SWEEP_OP_DIGEST)
+			snprintf(label, sizeof(label), "%s data %lu",
+				 ckm2str(profile->type), data_size);
+		else
+			snprintf(label, sizeof(label), "%s key %lu data %lu",
+				 ckm2str(profile->type), sizes[s], data_size);
+		xtest_bench_stats_print(label, &stats);
+	}
+
+	xtest_bench_stats_free(&stats);
+}
+
+static void xtest_pkcs11_benchmark_1002(ADBG_Case_t *c)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_SLOT_ID slot = 0;
+	CK_SESSION_HANDLE session = CK_INVALID_HANDLE;
+	CK_FLAGS session_flags = CKF_SERIAL_SESSION | CKF_RW_SESSION;
+	CK_MECHANISM_TYPE_PTR mechas = NULL;
+	CK_MECHANISM_INFO *infos = NULL;
+	CK_ULONG count = 0;
+	struct sweep_profile profile = { };
+	char flags[80] = { };
+	size_t n = 0;
+
+	rv = init_lib_and_find_token_slot(&slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		return;
+
+	rv = init_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = init_user_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = C_GetMechanismList(slot, NULL, &count);
+	if (!ADBG_EXPECT_CK_OK(c, rv) ||
+	    !ADBG_EXPECT_COMPARE_UNSIGNED(c, count, !=, 0))
+		goto close_lib;
+
+	mechas = k_calloc(count, sizeof(*mechas));
+	infos = k_calloc(count, sizeof(*infos));
+	if (!ADBG_EXPECT_NOT_NULL(c, mechas) ||
+	    !ADBG_EXPECT_NOT_NULL(c, infos))
+		goto out;
+
+	rv = C_GetMechanismList(slot, mechas, &count);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	Do_ADBG_BeginSubCase(c, "Capabilities");
+
+	printk("    %-32s %8s %8s  %s\n", "mechanism", "min key", "max key",
+	       "flags");
+	for (n = 0; n < count; n++) {
+		rv = C_GetMechanismInfo(slot, mechas[n], infos + n);
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+
+		sweep_flags_str(infos[n].flags, flags, sizeof(flags));
+		printk("    %-32s %8lu %8lu  %s%s\n", ckm2str(mechas[n]),
+		       infos[n].ulMinKeySize, infos[n].ulMaxKeySize, flags,
+		       sweep_get_profile(mechas[n], infos + n, &profile) ?
+		       "" : " (no benchmark)");
+	}
+
+	Do_ADBG_EndSubCase(c, "Capabilities");
+
+	rv = C_OpenSession(slot, session_flags, NULL, 0, &session);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	rv = C_Login(session, CKU_USER, test_token_user_pin,
+		     sizeof(test_token_user_pin));
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_session;
+
+	Do_ADBG_BeginSubCase(c, "Performance");
+
+	for (n = 0; n < count; n++)
+		if (sweep_get_profile(mechas[n], infos + n, &profile))
+			sweep_mechanism(c, session, &profile, infos + n);
+
+	Do_ADBG_EndSubCase(c, "Performance");
+
+	ADBG_EXPECT_CK_OK(c, C_Logout(session));
+close_session:
+	ADBG_EXPECT_CK_OK(c, C_CloseSession(session));
+out:
+	k_free(infos);
+	k_free(mechas);
+close_lib:
+	ADBG_EXPECT_CK_OK(c, close_lib());
+}
+
+ZTEST(pkcs11_benchmark, test_1002)
+{
+	ADBG_STRUCT_DECLARE("PKCS11: Mechanism capability and performance sweep");
+
+	xtest_pkcs11_benchmark_1002(&c);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Key derivation throughput
+ *
+ * Derived keys per second for the AES encrypt-data derivations and, when
+ * the token supports it, ECDH1 derivation on the NIST curves. Each case
+ * is run with the derived key created as a session object and as a token
+ * object, the latter adding the secure storage write to every derivation.
+ */
+#define DERIVE_ITERATIONS		32
+#define DERIVE_DATA_SIZE		16
+/* Uncompressed P-521 point in a DER OCTET STRING */
+#define DERIVE_EC_POINT_MAX_SIZE	140
+
+static void derive_batch(ADBG_Case_t *c, CK_SESSION_HANDLE session,
+			 const char *name, CK_MECHANISM_PTR mecha,
+			 CK_OBJECT_HANDLE parent, CK_KEY_TYPE key_type,
+			 CK_ULONG key_len, CK_BBOOL token)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_OBJECT_CLASS key_class = CKO_SECRET_KEY;
+	CK_ATTRIBUTE derived_key_template[] = {
+		{ CKA_CLASS, &key_class, sizeof(key_class) },
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_TOKEN, &token, sizeof(token) },
+		{ CKA_ENCRYPT, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_DECRYPT, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_VALUE_LEN, &key_len, sizeof(key_len) },
+	};
+	CK_OBJECT_HANDLE derived_key = CK_INVALID_HANDLE;
+	struct xtest_bench_stats stats = { };
+	char label[48] = { };
+	uint64_t t = 0;
+	size_t n = 0;
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&stats,
+						      DERIVE_ITERATIONS)))
+		return;
+
+	for (n = 0; n < DERIVE_ITERATIONS; n++) {
+		t = xtest_bench_now_ns();
+		rv = C_DeriveKey(session, mecha, parent, derived_key_template,
+				 ARRAY_SIZE(derived_key_template),
+				 &derived_key);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+
+		xtest_bench_stats_add(&stats, t);
+
+		rv = C_DestroyObject(session, derived_key);
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+	}
+
+	snprintf(label, sizeof(label), "%s, %s object", name,
+		 token ? "token" : "session");
+	xtest_bench_stats_print(label, &stats);
+
+out:
+	xtest_bench_stats_free(&stats);
+}
+
+static void derive_aes_bench(ADBG_Case_t *c, CK_SESSION_HANDLE session,
+			     CK_BBOOL token)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_BYTE data[DERIVE_DATA_SIZE] = { };
+	CK_KEY_DERIVATION_STRING_DATA ecb_param = {
+		.pData = data,
+		.ulLen = sizeof(data),
+	};
+	CK_AES_CBC_ENCRYPT_DATA_PARAMS cbc_param = {
+		.pData = data,
+		.length = sizeof(data),
+	};
+	CK_MECHANISM ecb_mecha = {
+		CKM_AES_ECB_ENCRYPT_DATA, &ecb_param, sizeof(ecb_param),
+	};
+	CK_MECHANISM cbc_mecha = {
+		CKM_AES_CBC_ENCRYPT_DATA, &cbc_param, sizeof(cbc_param),
+	};
+	CK_ATTRIBUTE parent_template[] = {
+		{ CKA_VALUE_LEN, &(CK_ULONG){ 16 }, sizeof(CK_ULONG) },
+		{ CKA_DERIVE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+	CK_OBJECT_HANDLE parent = CK_INVALID_HANDLE;
+
+	rv = C_GenerateKey(session, &cktest_aes_keygen_mechanism,
+			   parent_template, ARRAY_SIZE(parent_template),
+			   &parent);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		return;
+
+	derive_batch(c, session, "AES-ECB encrypt data", &ecb_mecha, parent,
+		     CKK_AES, DERIVE_DATA_SIZE, token);
+	derive_batch(c, session, "AES-CBC encrypt data", &cbc_mecha, parent,
+		     CKK_AES, DERIVE_DATA_SIZE, token);
+
+	ADBG_EXPECT_CK_OK(c, C_DestroyObject(session, parent));
+}
+
+static const struct {
+	const char *name;
+	uint8_t *ec_params;
+	size_t ec_params_size;
+	/* Size of the shared secret in bytes */
+	CK_ULONG secret_len;
+} derive_ecdh_curves[] = {
+	{ "ECDH1 P-256", ecdsa_nist_p256, sizeof(ecdsa_nist_p256), 32 },
+	{ "ECDH1 P-384", ecdsa_nist_p384, sizeof(ecdsa_nist_p384), 48 },
+	{ "ECDH1 P-521", ecdsa_nist_p521, sizeof(ecdsa_nist_p521), 66 },
+};
+
+static CK_RV derive_gen_ec_key_pair(CK_SESSION_HANDLE session,
+				    uint8_t *ec_params, size_t ec_params_size,
+				    CK_OBJECT_HANDLE *pub,
+				    CK_OBJECT_HANDLE *priv)
+{
+	CK_MECHANISM mecha = { CKM_EC_KEY_PAIR_GEN, NULL, 0 };
+	CK_ATTRIBUTE public_template[] = {
+		{ CKA_EC_PARAMS, ec_params, ec_params_size },
+	};
+	CK_ATTRIBUTE private_template[] = {
+		{ CKA_DERIVE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+
+	return C_GenerateKeyPair(session, &mecha, public_template,
+				 ARRAY_SIZE(public_template), private_template,
+				 ARRAY_SIZE(private_template), pub, priv);
+}
+
+static void derive_ecdh_bench(ADBG_Case_t *c, CK_SESSION_HANDLE session,
+			      size_t idx, CK_BBOOL token)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_OBJECT_HANDLE pub = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE priv = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE peer_pub = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE peer_priv = CK_INVALID_HANDLE;
+	CK_BYTE peer_point[DERIVE_EC_POINT_MAX_SIZE] = { };
+	CK_ATTRIBUTE peer_point_template[] = {
+		{ CKA_EC_POINT, peer_point, sizeof(peer_point) },
+	};
+	CK_ECDH1_DERIVE_PARAMS ecdh_param = {
+		.kdf = CKD_NULL,
+	};
+	CK_MECHANISM ecdh_mecha = {
+		CKM_ECDH1_DERIVE, &ecdh_param, sizeof(ecdh_param),
+	};
+
+	rv = derive_gen_ec_key_pair(session, derive_ecdh_curves[idx].ec_params,
+				    derive_ecdh_curves[idx].ec_params_size,
+				    &pub, &priv);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		return;
+
+	rv = derive_gen_ec_key_pair(session, derive_ecdh_curves[idx].ec_params,
+				    derive_ecdh_curves[idx].ec_params_size,
+				    &peer_pub, &peer_priv);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	rv = C_GetAttributeValue(session, peer_pub, peer_point_template,
+				 ARRAY_SIZE(peer_point_template));
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	ecdh_param.pPublicData = peer_point;
+	ecdh_param.ulPublicDataLen = peer_point_template[0].ulValueLen;
+
+	derive_batch(c, session, derive_ecdh_curves[idx].name, &ecdh_mecha,
+		     priv, CKK_GENERIC_SECRET,
+		     derive_ecdh_curves[idx].secret_len, token);
+
+out:
+	ADBG_EXPECT_CK_OK(c, sweep_destroy_key(session, peer_pub, peer_priv));
+	ADBG_EXPECT_CK_OK(c, sweep_destroy_key(session, pub, priv));
+}
+
+static void xtest_pkcs11_benchmark_1003(ADBG_Case_t *c)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_SLOT_ID slot = 0;
+	CK_SESSION_HANDLE session = CK_INVALID_HANDLE;
+	CK_FLAGS session_flags = CKF_SERIAL_SESSION | CKF_RW_SESSION;
+	bool aes_ecb = false;
+	bool aes_cbc = false;
+	bool ecdh = false;
+	CK_BBOOL token = CK_FALSE;
+	size_t n = 0;
+
+	rv = init_lib_and_find_token_slot(&slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		return;
+
+	rv = init_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = init_user_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	aes_ecb = mechanism_is_supported(slot, CKM_AES_ECB_ENCRYPT_DATA,
+					 CKF_DERIVE);
+	aes_cbc = mechanism_is_supported(slot, CKM_AES_CBC_ENCRYPT_DATA,
+					 CKF_DERIVE);
+	ecdh = mechanism_is_supported(slot, CKM_ECDH1_DERIVE, CKF_DERIVE);
+	if (!aes_ecb || !aes_cbc)
+		Do_ADBG_Log("    AES encrypt data derivation not supported, skipped");
+	if (!ecdh)
+		Do_ADBG_Log("    CKM_ECDH1_DERIVE not supported, skipped");
+
+	rv = C_OpenSession(slot, session_flags, NULL, 0, &session);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	/* Token objects are private to the user */
+	rv = C_Login(session, CKU_USER, test_token_user_pin,
+		     sizeof(test_token_user_pin));
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_session;
+
+	for (token = CK_FALSE; token <= CK_TRUE; token++) {
+		Do_ADBG_BeginSubCase(c, "Derive into %s objects",
+				     token ? "token" : "session");
+
+		if (aes_ecb && aes_cbc)
+			derive_aes_bench(c, session, token);
+
+		for (n = 0; ecdh && n < ARRAY_SIZE(derive_ecdh_curves); n++)
+			derive_ecdh_bench(c, session, n, token);
+
+		Do_ADBG_EndSubCase(c, "Derive into %s objects",
+				   token ? "token" : "session");
+	}
+
+	ADBG_EXPECT_CK_OK(c, C_Logout(session));
+close_session:
+	ADBG_EXPECT_CK_OK(c, C_CloseSession(session));
+close_lib:
+	ADBG_EXPECT_CK_OK(c, close_lib());
+}
+
+ZTEST(pkcs11_benchmark, test_1003)
+{
+	ADBG_STRUCT_DECLARE("PKCS11: Key derivation throughput");
+
+	xtest_pkcs11_benchmark_1003(&c);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Template serialization cost
+ *
+ * Objects are created from templates of increasing weight and read back
+ * with C_GetAttributeValue(). The libckteec serializer is internal to the
+ * library, so its cost is not timed directly: the minimal template gives
+ * the fixed cost of a TEE round trip, and the excess latency of the other
+ * templates over it is attribute marshalling (client serialization,
+ * shared memory copy and TA side parsing). Attribute size queries
+ * (pValue == NULL) cost a round trip without value copies, so the gap
+ * between the full read and the size query is the cost of returning the
+ * values.
+ */
+#define SERIAL_ITERATIONS	32
+#define SERIAL_MAX_ATTRS	20
+#define SERIAL_CERT_SIZE	2048
+
+struct serial_baseline {
+	uint64_t create_ns;
+	uint64_t get_ns;
+};
+
+/*
+ * Serialized size of the value of @attr: libckteec passes CK_ULONG values
+ * to the TA as 32-bit words.
+ */
+static size_t serial_value_size(CK_ATTRIBUTE_PTR attr)
+{
+	switch (attr->type) {
+	case CKA_CLASS:
+	case CKA_KEY_TYPE:
+	case CKA_CERTIFICATE_TYPE:
+	case CKA_CERTIFICATE_CATEGORY:
+	case CKA_JAVA_MIDP_SECURITY_DOMAIN:
+	case CKA_NAME_HASH_ALGORITHM:
+	case CKA_KEY_GEN_MECHANISM:
+	case CKA_MECHANISM_TYPE:
+	case CKA_MODULUS_BITS:
+	case CKA_VALUE_LEN:
+		return sizeof(uint32_t);
+	case CKA_ALLOWED_MECHANISMS:
+		return attr->ulValueLen / sizeof(CK_ULONG) * sizeof(uint32_t);
+	default:
+		return attr->ulValueLen;
+	}
+}
+
+/* Size of @template in the libckteec serialized format */
+static size_t serial_template_size(CK_ATTRIBUTE_PTR template, CK_ULONG count)
+{
+	/* Object head: attributes count and size */
+	size_t size = 2 * sizeof(uint32_t);
+	CK_ULONG n = 0;
+
+	/* Attribute head: ID and size, then the value */
+	for (n = 0; n < count; n++)
+		size += 2 * sizeof(uint32_t) + serial_value_size(template + n);
+
+	return size;
+}
+
+static uint64_t serial_delta(uint64_t ns, uint64_t baseline_ns)
+{
+	return ns > baseline_ns ? ns - baseline_ns : 0;
+}
+
+static void serial_bench(ADBG_Case_t *c, CK_SESSION_HANDLE session,
+			 const char *name, CK_ATTRIBUTE_PTR template,
+			 CK_ULONG count, struct serial_baseline *baseline)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_ATTRIBUTE get_template[SERIAL_MAX_ATTRS] = { };
+	CK_ATTRIBUTE size_template[SERIAL_MAX_ATTRS] = { };
+	CK_OBJECT_HANDLE obj = CK_INVALID_HANDLE;
+	struct xtest_bench_stats create_stats = { };
+	struct xtest_bench_stats size_stats = { };
+	struct xtest_bench_stats get_stats = { };
+	size_t payload = serial_template_size(template, count);
+	size_t readback_size = 0;
+	uint8_t *readback = NULL;
+	uint8_t *p = NULL;
+	char label[48] = { };
+	uint64_t t = 0;
+	size_t n = 0;
+
+	if (!ADBG_EXPECT_COMPARE_UNSIGNED(c, count, <=, SERIAL_MAX_ATTRS))
+		return;
+
+	for (n = 0; n < count; n++)
+		readback_size += template[n].ulValueLen;
+
+	readback = k_malloc(readback_size);
+	if (!ADBG_EXPECT_NOT_NULL(c, readback))
+		return;
+
+	for (n = 0, p = readback; n < count; n++) {
+		size_template[n].type = template[n].type;
+		get_template[n].type = template[n].type;
+		get_template[n].pValue = p;
+		get_template[n].ulValueLen = template[n].ulValueLen;
+		p += template[n].ulValueLen;
+	}
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&create_stats,
+						      SERIAL_ITERATIONS)) ||
+	    !ADBG_EXPECT(c, 0, xtest_bench_stats_init(&size_stats,
+						      SERIAL_ITERATIONS)) ||
+	    !ADBG_EXPECT(c, 0, xtest_bench_stats_init(&get_stats,
+						      SERIAL_ITERATIONS)))
+		goto out;
+
+	for (n = 0; n < SERIAL_ITERATIONS; n++) {
+		t = xtest_bench_now_ns();
+		rv = C_CreateObject(session, template, count, &obj);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+		xtest_bench_stats_add(&create_stats, t);
+
+		t = xtest_bench_now_ns();
+		rv = C_GetAttributeValue(session, obj, size_template, count);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto destroy;
+		xtest_bench_stats_add(&size_stats, t);
+
+		t = xtest_bench_now_ns();
+		rv = C_GetAttributeValue(session, obj, get_template, count);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto destroy;
+		xtest_bench_stats_add(&get_stats, t);
+
+		rv = C_DestroyObject(session, obj);
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+		obj = CK_INVALID_HANDLE;
+	}
+
+	Do_ADBG_Log("    %s: %lu attributes, %zu bytes serialized", name,
+		    count, payload);
+
+	snprintf(label, sizeof(label), "%s create", name);
+	xtest_bench_stats_print(label, &create_stats);
+	snprintf(label, sizeof(label), "%s get size", name);
+	xtest_bench_stats_print(label, &size_stats);
+	snprintf(label, sizeof(label), "%s get", name);
+	xtest_bench_stats_print(label, &get_stats);
+
+	if (!baseline->create_ns) {
+		baseline->create_ns = xtest_bench_stats_mean(&create_stats);
+		baseline->get_ns = xtest_bench_stats_mean(&get_stats);
+	} else {
+		printk("    %-40s create +" XTEST_BENCH_US_FMT
+		       " us  get +" XTEST_BENCH_US_FMT
+		       " us  value copy " XTEST_BENCH_US_FMT " us\n",
+		       "  marshalling over round trip",
+		       XTEST_BENCH_US(serial_delta(
+				xtest_bench_stats_mean(&create_stats),
+				baseline->create_ns)),
+		       XTEST_BENCH_US(serial_delta(
+				xtest_bench_stats_mean(&get_stats),
+				baseline->get_ns)),
+		       XTEST_BENCH_US(serial_delta(
+				xtest_bench_stats_mean(&get_stats),
+				xtest_bench_stats_mean(&size_stats))));
+	}
+
+destroy:
+	if (obj != CK_INVALID_HANDLE)
+		ADBG_EXPECT_CK_OK(c, C_DestroyObject(session, obj));
+out:
+	xtest_bench_stats_free(&get_stats);
+	xtest_bench_stats_free(&size_stats);
+	xtest_bench_stats_free(&create_stats);
+	k_free(readback);
+}
+
+static const size_t serial_data_sizes[] = { 1024, 4096, 16384 };
+
+static void xtest_pkcs11_benchmark_1004(ADBG_Case_t *c)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_SLOT_ID slot = 0;
+	CK_SESSION_HANDLE session = CK_INVALID_HANDLE;
+	CK_FLAGS session_flags = CKF_SERIAL_SESSION | CKF_RW_SESSION;
+	struct serial_baseline baseline = { };
+	CK_MECHANISM_TYPE_PTR mechas = NULL;
+	CK_ULONG mechas_count = 0;
+	uint8_t *value = NULL;
+	const char *label = "xtest serialization benchmark";
+	const char *application = "xtest";
+	CK_BYTE id[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+	CK_DATE start_date = { .year = "2023", .month = "01", .day = "01" };
+	CK_DATE end_date = { .year = "2043", .month = "12", .day = "31" };
+	CK_BYTE secret[32] = { };
+	/* DER INTEGER serial number */
+	CK_BYTE serial_number[] = { 0x02, 0x08, 0x1a, 0x2b, 0x3c, 0x4d,
+				    0x5e, 0x6f, 0x70, 0x81 };
+	char name[40] = { };
+	size_t n = 0;
+
+	rv = init_lib_and_find_token_slot(&slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		return;
+
+	rv = init_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = init_user_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	/* Largest value buffer, also used as certificate DER */
+	value = k_calloc(1, serial_data_sizes[ARRAY_SIZE(serial_data_sizes) - 1]);
+	if (!ADBG_EXPECT_NOT_NULL(c, value))
+		goto close_lib;
+
+	/* Allowed mechanisms list is the token mechanism list */
+	rv = C_GetMechanismList(slot, NULL, &mechas_count);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	mechas = k_calloc(mechas_count, sizeof(*mechas));
+	if (!ADBG_EXPECT_NOT_NULL(c, mechas))
+		goto out;
+
+	rv = C_GetMechanismList(slot, mechas, &mechas_count);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	rv = C_OpenSession(slot, session_flags, NULL, 0, &session);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	rv = C_Login(session, CKU_USER, test_token_user_pin,
+		     sizeof(test_token_user_pin));
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_session;
+
+	Do_ADBG_BeginSubCase(c, "Minimal template");
+	{
+		CK_ATTRIBUTE template[] = {
+			{ CKA_CLASS, &(CK_OBJECT_CLASS){ CKO_DATA },
+			  sizeof(CK_OBJECT_CLASS) },
+			{ CKA_VALUE, value, 1 },
+		};
+
+		serial_bench(c, session, "minimal", template,
+			     ARRAY_SIZE(template), &baseline);
+	}
+	Do_ADBG_EndSubCase(c, "Minimal template");
+
+	Do_ADBG_BeginSubCase(c, "Large CKA_VALUE");
+	for (n = 0; n < ARRAY_SIZE(serial_data_sizes); n++) {
+		CK_ATTRIBUTE template[] = {
+			{ CKA_CLASS, &(CK_OBJECT_CLASS){ CKO_DATA },
+			  sizeof(CK_OBJECT_CLASS) },
+			{ CKA_LABEL, (CK_UTF8CHAR_PTR)label, strlen(label) },
+			{ CKA_APPLICATION, (CK_UTF8CHAR_PTR)application,
+			  strlen(application) },
+			{ CKA_VALUE, value, serial_data_sizes[n] },
+		};
+
+		snprintf(name, sizeof(name), "data %zu bytes",
+			 serial_data_sizes[n]);
+		serial_bench(c, session, name, template, ARRAY_SIZE(template),
+			     &baseline);
+	}
+	Do_ADBG_EndSubCase(c, "Large CKA_VALUE");
+
+	Do_ADBG_BeginSubCase(c, "Many attributes");
+	{
+		CK_ATTRIBUTE template[] = {
+			{ CKA_CLASS, &(CK_OBJECT_CLASS){ CKO_SECRET_KEY },
+			  sizeof(CK_OBJECT_CLASS) },
+			{ CKA_KEY_TYPE, &(CK_KEY_TYPE){ CKK_GENERIC_SECRET },
+			  sizeof(CK_KEY_TYPE) },
+			{ CKA_TOKEN, &(CK_BBOOL){ CK_FALSE }, sizeof(CK_BBOOL) },
+			{ CKA_PRIVATE, &(CK_BBOOL){ CK_FALSE },
+			  sizeof(CK_BBOOL) },
+			{ CKA_LABEL, (CK_UTF8CHAR_PTR)label, strlen(label) },
+			{ CKA_ID, id, sizeof(id) },
+			{ CKA_START_DATE, &start_date, sizeof(start_date) },
+			{ CKA_END_DATE, &end_date, sizeof(end_date) },
+			{ CKA_ENCRYPT, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+			{ CKA_DECRYPT, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+			{ CKA_SIGN, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+			{ CKA_VERIFY, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+			{ CKA_DERIVE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+			{ CKA_SENSITIVE, &(CK_BBOOL){ CK_FALSE },
+			  sizeof(CK_BBOOL) },
+			{ CKA_EXTRACTABLE, &(CK_BBOOL){ CK_TRUE },
+			  sizeof(CK_BBOOL) },
+			{ CKA_MODIFIABLE, &(CK_BBOOL){ CK_TRUE },
+			  sizeof(CK_BBOOL) },
+			{ CKA_COPYABLE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+			{ CKA_DESTROYABLE, &(CK_BBOOL){ CK_TRUE },
+			  sizeof(CK_BBOOL) },
+			{ CKA_VALUE, secret, sizeof(secret) },
+		};
+
+		serial_bench(c, session, "secret key", template,
+			     ARRAY_SIZE(template), &baseline);
+	}
+	Do_ADBG_EndSubCase(c, "Many attributes");
+
+	Do_ADBG_BeginSubCase(c, "CKA_ALLOWED_MECHANISMS list");
+	{
+		CK_ATTRIBUTE template[] = {
+			{ CKA_CLASS, &(CK_OBJECT_CLASS){ CKO_SECRET_KEY },
+			  sizeof(CK_OBJECT_CLASS) },
+			{ CKA_KEY_TYPE, &(CK_KEY_TYPE){ CKK_GENERIC_SECRET },
+			  sizeof(CK_KEY_TYPE) },
+			{ CKA_SENSITIVE, &(CK_BBOOL){ CK_FALSE },
+			  sizeof(CK_BBOOL) },
+			{ CKA_EXTRACTABLE, &(CK_BBOOL){ CK_TRUE },
+			  sizeof(CK_BBOOL) },
+			{ CKA_ALLOWED_MECHANISMS, mechas,
+			  mechas_count * sizeof(*mechas) },
+			{ CKA_VALUE, secret, sizeof(secret) },
+		};
+
+		snprintf(name, sizeof(name), "%lu mechanisms", mechas_count);
+		serial_bench(c, session, name, template, ARRAY_SIZE(template),
+			     &baseline);
+	}
+	Do_ADBG_EndSubCase(c, "CKA_ALLOWED_MECHANISMS list");
+
+	Do_ADBG_BeginSubCase(c, "X.509 certificate");
+	{
+		/* Synthetic DER, the token stores it without parsing */
+		CK_ATTRIBUTE template[] = {
+			{ CKA_CLASS, &(CK_OBJECT_CLASS){ CKO_CERTIFICATE },
+			  sizeof(CK_OBJECT_CLASS) },
+			{ CKA_CERTIFICATE_TYPE,
+			  &(CK_CERTIFICATE_TYPE){ CKC_X_509 },
+			  sizeof(CK_CERTIFICATE_TYPE) },
+			{ CKA_TOKEN, &(CK_BBOOL){ CK_FALSE }, sizeof(CK_BBOOL) },
+			{ CKA_CERTIFICATE_CATEGORY,
+			  &(CK_ULONG){ CK_CERTIFICATE_CATEGORY_UNSPECIFIED },
+			  sizeof(CK_ULONG) },
+			{ CKA_ID, id, sizeof(id) },
+			{ CKA_LABEL, (CK_UTF8CHAR_PTR)label, strlen(label) },
+			{ CKA_SUBJECT, subject_common_name,
+			  sizeof(subject_common_name) },
+			{ CKA_ISSUER, subject_common_name,
+			  sizeof(subject_common_name) },
+			{ CKA_SERIAL_NUMBER, serial_number,
+			  sizeof(serial_number) },
+			{ CKA_VALUE, value, SERIAL_CERT_SIZE },
+		};
+
+		/* SEQUENCE header of the certificate body */
+		value[0] = 0x30;
+		value[1] = 0x82;
+		value[2] = (SERIAL_CERT_SIZE - 4) >> 8;
+		value[3] = (SERIAL_CERT_SIZE - 4) & 0xff;
+
+		serial_bench(c, session, "certificate", template,
+			     ARRAY_SIZE(template), &baseline);
+	}
+	Do_ADBG_EndSubCase(c, "X.509 certificate");
+
+	ADBG_EXPECT_CK_OK(c, C_Logout(session));
+close_session:
+	ADBG_EXPECT_CK_OK(c, C_CloseSession(session));
+out:
+	k_free(mechas);
+	k_free(value);
+close_lib:
+	ADBG_EXPECT_CK_OK(c, close_lib());
+}
+
+ZTEST(pkcs11_benchmark, test_1004)
+{
+	ADBG_STRUCT_DECLARE("PKCS11: Attribute template serialization cost");
+
+	xtest_pkcs11_benchmark_1004(&c);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Persistent key load cost
+ *
+ * The same key is used in four ways for one crypto operation: looked up
+ * as a token object by label on a session where the TA already holds it,
+ * through a handle kept across operations, imported as a session object
+ * from its attribute values then destroyed, and looked up again after the
+ * library was finalized and initialized, which closes the TEE session so
+ * the TA drops the client state and object handles. The last path reports
+ * the library reopen and login, the lookup and the first operation on the
+ * looked up key separately: it is the PKCS#11 counterpart of opening a
+ * persistent key object from a new client. Whether the TA then reads the
+ * object back from secure storage depends on its own caching of token
+ * objects. AES keys run one AES-ECB block encryption, RSA keys one
+ * CKM_RSA_PKCS signature.
+ */
+#define KEYLOAD_ITERATIONS	32
+#define KEYLOAD_IN_SIZE		32
+#define KEYLOAD_OUT_SIZE	512
+#define KEYLOAD_MAX_ATTRS	16
+#define KEYLOAD_RSA_BITS	2048
+
+static const CK_BYTE keyload_aes_value[16] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static CK_BYTE keyload_label[] = "bench_keyload";
+static CK_BYTE keyload_in[KEYLOAD_IN_SIZE];
+
+/* RSA private key components read back from a generated key pair */
+static const CK_ATTRIBUTE_TYPE keyload_rsa_attrs[] = {
+	CKA_MODULUS, CKA_PUBLIC_EXPONENT, CKA_PRIVATE_EXPONENT, CKA_PRIME_1,
+	CKA_PRIME_2, CKA_EXPONENT_1, CKA_EXPONENT_2, CKA_COEFFICIENT,
+};
+
+static CK_RV keyload_op(CK_SESSION_HANDLE session, CK_OBJECT_HANDLE key,
+			bool rsa)
+{
+	CK_MECHANISM rsa_mecha = { CKM_RSA_PKCS, NULL, 0 };
+	CK_BYTE out[KEYLOAD_OUT_SIZE] = { };
+	CK_ULONG out_len = sizeof(out);
+	CK_RV rv = CKR_GENERAL_ERROR;
+
+	if (rsa) {
+		rv = C_SignInit(session, &rsa_mecha, key);
+		if (rv != CKR_OK)
+			return rv;
+
+		return C_Sign(session, keyload_in, sizeof(keyload_in), out,
+			      &out_len);
+	}
+
+	rv = C_EncryptInit(session, &cktest_aes_ecb_mechanism, key);
+	if (rv != CKR_OK)
+		return rv;
+
+	return C_Encrypt(session, keyload_in, 16, out, &out_len);
+}
+
+static CK_RV keyload_find(CK_SESSION_HANDLE session, CK_OBJECT_HANDLE *key)
+{
+	CK_ATTRIBUTE find_template[] = {
+		{ CKA_TOKEN, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+		{ CKA_LABEL, keyload_label, sizeof(keyload_label) - 1 },
+	};
+	CK_ULONG count = 0;
+	CK_RV rv = CKR_GENERAL_ERROR;
+
+	rv = C_FindObjectsInit(session, find_template,
+			       ARRAY_SIZE(find_template));
+	if (rv != CKR_OK)
+		return rv;
+
+	rv = C_FindObjects(session, key, 1, &count);
+	if (rv == CKR_OK && count != 1)
+		rv = CKR_GENERAL_ERROR;
+
+	if (rv == CKR_OK)
+		return C_FindObjectsFinal(session);
+
+	C_FindObjectsFinal(session);
+	return rv;
+}
+
+/*
+ * Finalizes the library, then opens a new user session on @slot. On error
+ * *@session is CK_INVALID_HANDLE.
+ */
+static CK_RV keyload_reopen(CK_SLOT_ID slot, CK_SESSION_HANDLE *session)
+{
+	CK_FLAGS session_flags = CKF_SERIAL_SESSION | CKF_RW_SESSION;
+	CK_RV rv = CKR_GENERAL_ERROR;
+
+	*session = CK_INVALID_HANDLE;
+
+	/* Not initialized if a previous reopen failed in C_Initialize() */
+	rv = close_lib();
+	if (rv != CKR_OK && rv != CKR_CRYPTOKI_NOT_INITIALIZED)
+		return rv;
+
+	rv = C_Initialize(0);
+	if (rv != CKR_OK)
+		return rv;
+
+	rv = C_OpenSession(slot, session_flags, NULL, 0, session);
+	if (rv != CKR_OK) {
+		*session = CK_INVALID_HANDLE;
+		return rv;
+	}
+
+	rv = C_Login(*session, CKU_USER, test_token_user_pin,
+		     sizeof(test_token_user_pin));
+	if (rv != CKR_OK) {
+		C_CloseSession(*session);
+		*session = CK_INVALID_HANDLE;
+	}
+
+	return rv;
+}
+
+/*
+ * Token key lookup, each time from a reopened library. *@session and
+ * *@token_key are replaced by the handles of the last reopen,
+ * *@token_key is CK_INVALID_HANDLE if the key was not found. Returns the
+ * status of the last reopen: on error *@session is CK_INVALID_HANDLE.
+ */
+static CK_RV keyload_reload_bench(ADBG_Case_t *c, CK_SLOT_ID slot,
+				 CK_SESSION_HANDLE *session,
+				 CK_OBJECT_HANDLE *token_key,
+				 const char *name, bool rsa)
+{
+	CK_RV reopen_rv = CKR_OK;
+	CK_RV rv = CKR_GENERAL_ERROR;
+	struct xtest_bench_stats stats[3] = { };
+	char label[48] = { };
+	uint64_t t[4] = { };
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(stats); n++) {
+		if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(stats + n,
+						KEYLOAD_ITERATIONS)))
+			goto out;
+	}
+
+	for (n = 0; n < KEYLOAD_ITERATIONS; n++) {
+		*token_key = CK_INVALID_HANDLE;
+
+		t[0] = xtest_bench_now_ns();
+		reopen_rv = keyload_reopen(slot, session);
+		t[1] = xtest_bench_now_ns();
+		rv = reopen_rv;
+		if (rv == CKR_OK)
+			rv = keyload_find(*session, token_key);
+		t[2] = xtest_bench_now_ns();
+		if (rv == CKR_OK)
+			rv = keyload_op(*session, *token_key, rsa);
+		t[3] = xtest_bench_now_ns();
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto out;
+
+		xtest_bench_stats_add(stats, t[1] - t[0]);
+		xtest_bench_stats_add(stats + 1, t[2] - t[1]);
+		xtest_bench_stats_add(stats + 2, t[3] - t[2]);
+	}
+
+	snprintf(label, sizeof(label), "%s, reopen library and login", name);
+	xtest_bench_stats_print(label, stats);
+	snprintf(label, sizeof(label), "%s, token key lookup after reopen",
+		 name);
+	xtest_bench_stats_print(label, stats + 1);
+	snprintf(label, sizeof(label), "%s, first use after reopen", name);
+	xtest_bench_stats_print(label, stats + 2);
+
+out:
+	for (n = 0; n < ARRAY_SIZE(stats); n++)
+		xtest_bench_stats_free(stats + n);
+
+	return reopen_rv;
+}
+
+/*
+ * @template holds the key attributes, CKA_TOKEN and CKA_LABEL are added
+ * here. The library is reopened, *@session is replaced by the new session.
+ */
+static void keyload_bench(ADBG_Case_t *c, CK_SLOT_ID slot,
+			  CK_SESSION_HANDLE *session, const char *name,
+			  CK_ATTRIBUTE_PTR template, CK_ULONG count, bool rsa)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_ATTRIBUTE key_template[KEYLOAD_MAX_ATTRS] = { };
+	CK_BBOOL token = CK_TRUE;
+	CK_OBJECT_HANDLE token_key = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE key = CK_INVALID_HANDLE;
+	struct xtest_bench_stats stats = { };
+	char label[48] = { };
+	uint64_t t = 0;
+	size_t n = 0;
+
+	if (!ADBG_EXPECT_COMPARE_UNSIGNED(c, count + 2, <=,
+					  ARRAY_SIZE(key_template)))
+		return;
+
+	memcpy(key_template, template, count * sizeof(*template));
+	key_template[count] = (CK_ATTRIBUTE){
+		CKA_TOKEN, &token, sizeof(token),
+	};
+	key_template[count + 1] = (CK_ATTRIBUTE){
+		CKA_LABEL, keyload_label, sizeof(keyload_label) - 1,
+	};
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&stats,
+						      KEYLOAD_ITERATIONS)))
+		return;
+
+	rv = C_CreateObject(*session, key_template, count + 2, &token_key);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	for (n = 0; n < KEYLOAD_ITERATIONS; n++) {
+		t = xtest_bench_now_ns();
+		rv = keyload_find(*session, &key);
+		if (rv == CKR_OK)
+			rv = keyload_op(*session, key, rsa);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto destroy;
+
+		xtest_bench_stats_add(&stats, t);
+	}
+
+	snprintf(label, sizeof(label), "%s, token key lookup, loaded", name);
+	xtest_bench_stats_print(label, &stats);
+	xtest_bench_stats_reset(&stats);
+
+	for (n = 0; n < KEYLOAD_ITERATIONS; n++) {
+		t = xtest_bench_now_ns();
+		rv = keyload_op(*session, token_key, rsa);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto destroy;
+
+		xtest_bench_stats_add(&stats, t);
+	}
+
+	snprintf(label, sizeof(label), "%s, cached handle", name);
+	xtest_bench_stats_print(label, &stats);
+	xtest_bench_stats_reset(&stats);
+
+	/* Session object, without label */
+	token = CK_FALSE;
+	for (n = 0; n < KEYLOAD_ITERATIONS; n++) {
+		t = xtest_bench_now_ns();
+		rv = C_CreateObject(*session, key_template, count + 1, &key);
+		if (rv == CKR_OK) {
+			rv = keyload_op(*session, key, rsa);
+			if (rv == CKR_OK)
+				rv = C_DestroyObject(*session, key);
+			else
+				C_DestroyObject(*session, key);
+		}
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_CK_OK(c, rv))
+			goto destroy;
+
+		xtest_bench_stats_add(&stats, t);
+	}
+
+	snprintf(label, sizeof(label), "%s, import from attributes", name);
+	xtest_bench_stats_print(label, &stats);
+
+	/* Last, the reopen invalidates the session and object handles */
+	rv = keyload_reload_bench(c, slot, session, &token_key, name, rsa);
+
+	/* After a failure, reach the persistent key by label to remove it */
+	if (rv != CKR_OK && keyload_reopen(slot, session) != CKR_OK) {
+		Do_ADBG_Log("    %s: no session, token key left on the token",
+			    name);
+		goto out;
+	}
+	if (token_key == CK_INVALID_HANDLE &&
+	    keyload_find(*session, &token_key) != CKR_OK) {
+		Do_ADBG_Log("    %s: token key not found for removal", name);
+		goto out;
+	}
+
+destroy:
+	ADBG_EXPECT_CK_OK(c, C_DestroyObject(*session, token_key));
+out:
+	xtest_bench_stats_free(&stats);
+}
+
+static void keyload_aes_bench(ADBG_Case_t *c, CK_SLOT_ID slot,
+			      CK_SESSION_HANDLE *session)
+{
+	CK_OBJECT_CLASS key_class = CKO_SECRET_KEY;
+	CK_KEY_TYPE key_type = CKK_AES;
+	CK_ATTRIBUTE template[] = {
+		{ CKA_CLASS, &key_class, sizeof(key_class) },
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_VALUE, (CK_VOID_PTR)keyload_aes_value,
+		  sizeof(keyload_aes_value) },
+		{ CKA_ENCRYPT, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+
+	keyload_bench(c, slot, session, "AES-128", template,
+		      ARRAY_SIZE(template), false);
+}
+
+static void keyload_rsa_bench(ADBG_Case_t *c, CK_SLOT_ID slot,
+			      CK_SESSION_HANDLE *session)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_MECHANISM mecha = { CKM_RSA_PKCS_KEY_PAIR_GEN, NULL, 0 };
+	CK_ULONG modulus_bits = KEYLOAD_RSA_BITS;
+	CK_ATTRIBUTE public_template[] = {
+		{ CKA_MODULUS_BITS, &modulus_bits, sizeof(modulus_bits) },
+		{ CKA_PUBLIC_EXPONENT, rsa_public_exponent,
+		  sizeof(rsa_public_exponent) },
+	};
+	CK_ATTRIBUTE private_template[] = {
+		{ CKA_SENSITIVE, &(CK_BBOOL){ CK_FALSE }, sizeof(CK_BBOOL) },
+		{ CKA_EXTRACTABLE, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+	CK_OBJECT_CLASS key_class = CKO_PRIVATE_KEY;
+	CK_KEY_TYPE key_type = CKK_RSA;
+	CK_ATTRIBUTE template[ARRAY_SIZE(keyload_rsa_attrs) + 3] = {
+		{ CKA_CLASS, &key_class, sizeof(key_class) },
+		{ CKA_KEY_TYPE, &key_type, sizeof(key_type) },
+		{ CKA_SIGN, &(CK_BBOOL){ CK_TRUE }, sizeof(CK_BBOOL) },
+	};
+	CK_OBJECT_HANDLE pub = CK_INVALID_HANDLE;
+	CK_OBJECT_HANDLE priv = CK_INVALID_HANDLE;
+	size_t value_size = KEYLOAD_RSA_BITS / 8;
+	uint8_t *values = NULL;
+	size_t i = 0;
+
+	values = k_malloc(ARRAY_SIZE(keyload_rsa_attrs) * value_size);
+	if (!ADBG_EXPECT_NOT_NULL(c, values))
+		return;
+
+	rv = C_GenerateKeyPair(*session, &mecha, public_template,
+			       ARRAY_SIZE(public_template), private_template,
+			       ARRAY_SIZE(private_template), &pub, &priv);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto out;
+
+	for (i = 0; i < ARRAY_SIZE(keyload_rsa_attrs); i++) {
+		template[3 + i] = (CK_ATTRIBUTE){
+			keyload_rsa_attrs[i], values + i * value_size,
+			value_size,
+		};
+	}
+
+	rv = C_GetAttributeValue(*session, priv, template + 3,
+				 ARRAY_SIZE(keyload_rsa_attrs));
+
+	/* The pair is a session object, gone once the library is reopened */
+	ADBG_EXPECT_CK_OK(c, sweep_destroy_key(*session, pub, priv));
+
+	if (ADBG_EXPECT_CK_OK(c, rv))
+		keyload_bench(c, slot, session, "RSA-2048", template,
+			      ARRAY_SIZE(template), true);
+out:
+	k_free(values);
+}
+
+static void xtest_pkcs11_benchmark_1005(ADBG_Case_t *c)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_SLOT_ID slot = 0;
+	CK_SESSION_HANDLE session = CK_INVALID_HANDLE;
+	CK_FLAGS session_flags = CKF_SERIAL_SESSION | CKF_RW_SESSION;
+
+	rv = init_lib_and_find_token_slot(&slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		return;
+
+	rv = init_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = init_user_test_token(slot);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	rv = C_OpenSession(slot, session_flags, NULL, 0, &session);
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_lib;
+
+	/* Token objects are private to the user */
+	rv = C_Login(session, CKU_USER, test_token_user_pin,
+		     sizeof(test_token_user_pin));
+	if (!ADBG_EXPECT_CK_OK(c, rv))
+		goto close_session;
+
+	if (mechanism_is_supported(slot, CKM_AES_ECB, CKF_ENCRYPT))
+		keyload_aes_bench(c, slot, &session);
+	else
+		Do_ADBG_Log("    CKM_AES_ECB not supported, skipped");
+
+	/* Lost in a failed library reopen, already reported */
+	if (session == CK_INVALID_HANDLE)
+		goto close_lib;
+
+	if (mechanism_is_supported(slot, CKM_RSA_PKCS, CKF_SIGN) &&
+	    mechanism_is_supported(slot, CKM_RSA_PKCS_KEY_PAIR_GEN,
+				   CKF_GENERATE_KEY_PAIR))
+		keyload_rsa_bench(c, slot, &session);
+	else
+		Do_ADBG_Log("    RSA PKCS#1 v1.5 not supported, skipped");
+
+	if (session == CK_INVALID_HANDLE)
+		goto close_lib;
+
+	ADBG_EXPECT_CK_OK(c, C_Logout(session));
+close_session:
+	ADBG_EXPECT_CK_OK(c, C_CloseSession(session));
+close_lib:
+	ADBG_EXPECT_CK_OK(c, close_lib());
+}
+
+ZTEST(pkcs11_benchmark, test_1005)
+{
+	ADBG_STRUCT_DECLARE("PKCS11: Persistent key load cost");
+
+	xtest_pkcs11_benchmark_1005(&c);
+	ADBG_Assert(&c);
+}
+
+ZTEST_SUITE(pkcs11_benchmark, NULL, pkcs11_benchmark_init, NULL, NULL,
+	    pkcs11_benchmark_deinit);
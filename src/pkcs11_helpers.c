@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2018, Linaro Limited
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <pkcs11.h>
+#include <stdlib.h>
+
+#include "pkcs11_helpers.h"
+
+/*
+ * Util to find a slot on which to open a session
+ */
+CK_RV close_lib(void)
+{
+	return C_Finalize(0);
+}
+
+CK_RV init_lib_and_find_token_slot(CK_SLOT_ID *slot)
+{
+	CK_RV rv = CKR_GENERAL_ERROR;
+	CK_SLOT_ID_PTR slots = NULL;
+	CK_ULONG count = 0;
+
+	rv = C_Initialize(0);
+	if (rv)
+		return rv;
+
+	rv = C_GetSlotList(CK_TRUE, NULL, &count);
+	if (rv != CKR_OK)
+		goto bail;
+
+	if (count < 1) {
+		rv = CKR_GENERAL_ERROR;
+		goto bail;
+	}
+
+	slots = malloc(count * sizeof(CK_SLOT_ID));
+	if (!slots) {
+		rv = CKR_HOST_MEMORY;
+		goto bail;
+	}
+
+	rv = C_GetSlotList(CK_TRUE, slots, &count);
+	if (rv)
+		goto bail;
+
+	/* Use the last slot */
+	*slot = slots[count - 1];
+
+bail:
+	free(slots);
+	if (rv)
+		close_lib();
+
+	return rv;
+}
+
+/*
+ * Helpers for tests where we must log into the token.
+ * These define the genuine PINs and label to be used with the test token.
+ */
+CK_UTF8CHAR test_token_so_pin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 , 9, 10, };
+CK_UTF8CHAR test_token_user_pin[] = {
+	1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+};
+CK_UTF8CHAR test_token_label[] = "PKCS11 TA test token";
+
+CK_RV init_test_token(CK_SLOT_ID slot)
+{
+	return C_InitToken(slot, test_token_so_pin, sizeof(test_token_so_pin),
+			   test_token_label);
+}
+
+/* Login as user, eventually reset user PIN if needed */
+CK_RV init_user_test_token(CK_SLOT_ID slot)
+{
+	CK_FLAGS session_flags = CKF_SERIAL_SESSION | CKF_RW_SESSION;
+	CK_SESSION_HANDLE session = CK_INVALID_HANDLE;
+	CK_RV rv = CKR_GENERAL_ERROR;
+
+	rv = C_OpenSession(slot, session_flags, NULL, 0, &session);
+	if (rv)
+		return rv;
+
+	rv = C_Login(session, CKU_USER,	test_token_user_pin,
+		     sizeof(test_token_user_pin));
+	if (rv == CKR_OK) {
+		C_Logout(session);
+		C_CloseSession(session);
+		return rv;
+	}
+
+	rv = C_Login(session, CKU_SO, test_token_so_pin,
+		     sizeof(test_token_so_pin));
+	if (rv) {
+		C_CloseSession(session);
+
+		rv = init_test_token(slot);
+		if (rv)
+			return rv;
+
+		rv = C_OpenSession(slot, session_flags, NULL, 0, &session);
+		if (rv)
+			return rv;
+
+		rv = C_Login(session, CKU_SO, test_token_so_pin,
+			     sizeof(test_token_so_pin));
+		if (rv) {
+			C_CloseSession(session);
+			return rv;
+		}
+	}
+
+	rv = C_InitPIN(session, test_token_user_pin,
+		       sizeof(test_token_user_pin));
+
+	C_Logout(session);
+	C_CloseSession(session);
+
+	return rv;
+}
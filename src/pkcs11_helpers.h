@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2018, Linaro Limited
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#ifndef PKCS11_HELPERS_H
+#define PKCS11_HELPERS_H
+
+#include <pkcs11.h>
+
+/* Genuine PINs and label to be used with the test token */
+extern CK_UTF8CHAR test_token_so_pin[11];
+extern CK_UTF8CHAR test_token_user_pin[12];
+extern CK_UTF8CHAR test_token_label[21];
+
+/* Finalize the Cryptoki library */
+CK_RV close_lib(void);
+
+/* Initialize the Cryptoki library and return the last slot with a token */
+CK_RV init_lib_and_find_token_slot(CK_SLOT_ID *slot);
+
+/* (Re)initialize the test token with the SO PIN and test label */
+CK_RV init_test_token(CK_SLOT_ID slot);
+
+/* Login as user, eventually reset user PIN if needed */
+CK_RV init_user_test_token(CK_SLOT_ID slot);
+
+#endif /*PKCS11_HELPERS_H*/
@@ -10,6 +10,7 @@
 #include <zephyr/ztest.h>
 #include <adbg.h>
 #include "optee_test.h"
+#include "storage_helpers.h"
 #include "xtest_helpers.h"
 
 #include <tee_client_api.h>
@@ -93,466 +94,6 @@ void regression_6000_deinit(void *param)
 	TEEC_FinalizeContext(&xtest_teec_ctx);
 }
 
-static TEEC_Result _fs_open(TEEC_Session *sess, void *id, uint32_t id_size,
-			   uint32_t flags, uint32_t *obj, uint32_t storage_id)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	TEEC_Result res = TEEC_ERROR_GENERIC;
-	uint32_t org = 0;
-
-	op.params[0].tmpref.buffer = id;
-	op.params[0].tmpref.size = id_size;
-	op.params[1].value.a = flags;
-	op.params[1].value.b = 0;
-	op.params[2].value.a = storage_id;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INPUT,
-					 TEEC_VALUE_INOUT, TEEC_VALUE_INPUT,
-					 TEEC_NONE);
-
-	res = TEEC_InvokeCommand(sess, TA_STORAGE_CMD_OPEN, &op, &org);
-
-	if (res == TEEC_SUCCESS)
-		*obj = op.params[1].value.b;
-
-	return res;
-}
-
-static TEEC_Result fs_create(TEEC_Session *sess, void *id, uint32_t id_size,
-			     uint32_t flags, uint32_t attr, void *data,
-			     uint32_t data_size, uint32_t *obj,
-			     uint32_t storage_id)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	TEEC_Result res = TEEC_ERROR_GENERIC;
-	uint32_t org = 0;
-
-	op.params[0].tmpref.buffer = id;
-	op.params[0].tmpref.size = id_size;
-	op.params[1].value.a = flags;
-	op.params[1].value.b = 0;
-	op.params[2].value.a = attr;
-	op.params[2].value.b = storage_id;
-	op.params[3].tmpref.buffer = data;
-	op.params[3].tmpref.size = data_size;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INPUT,
-					 TEEC_VALUE_INOUT, TEEC_VALUE_INPUT,
-					 TEEC_MEMREF_TEMP_INPUT);
-
-	res = TEEC_InvokeCommand(sess, TA_STORAGE_CMD_CREATE, &op, &org);
-
-	if (res == TEEC_SUCCESS)
-		*obj = op.params[1].value.b;
-
-	return res;
-}
-
-static TEEC_Result fs_create_overwrite(TEEC_Session *sess, void *id,
-				       uint32_t id_size, uint32_t storage_id)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	TEEC_Result res = TEEC_ERROR_GENERIC;
-	uint32_t org = 0;
-
-	op.params[0].tmpref.buffer = id;
-	op.params[0].tmpref.size = id_size;
-	op.params[1].value.a = storage_id;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INPUT,
-					 TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE);
-
-	res = TEEC_InvokeCommand(sess, TA_STORAGE_CMD_CREATE_OVERWRITE, &op, &org);
-
-	return res;
-}
-
-static TEEC_Result _fs_close(TEEC_Session *sess, uint32_t obj)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_CLOSE, &op, &org);
-}
-
-static TEEC_Result _fs_read(TEEC_Session *sess, uint32_t obj, void *data,
-			   uint32_t data_size, uint32_t *count)
-{
-	TEEC_Result res = TEEC_ERROR_GENERIC;
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].tmpref.buffer = data;
-	op.params[0].tmpref.size = data_size;
-	op.params[1].value.a = obj;
-	op.params[1].value.b = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_OUTPUT,
-					 TEEC_VALUE_INOUT, TEEC_NONE,
-					 TEEC_NONE);
-
-	res = TEEC_InvokeCommand(sess, TA_STORAGE_CMD_READ, &op, &org);
-
-	if (res == TEEC_SUCCESS)
-		*count = op.params[1].value.b;
-
-	return res;
-}
-
-static TEEC_Result _fs_write(TEEC_Session *sess, uint32_t obj, void *data,
-			    uint32_t data_size)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].tmpref.buffer = data;
-	op.params[0].tmpref.size = data_size;
-	op.params[1].value.a = obj;
-	op.params[1].value.b = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INPUT,
-					 TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_WRITE, &op, &org);
-}
-
-static TEEC_Result _fs_seek(TEEC_Session *sess, uint32_t obj, int32_t offset,
-			   int32_t whence)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-	op.params[0].value.b = *(uint32_t *)&offset;
-	op.params[1].value.a = whence;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_VALUE_INOUT,
-					 TEEC_NONE, TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_SEEK, &op, &org);
-}
-
-static TEEC_Result _fs_unlink(TEEC_Session *sess, uint32_t obj)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_UNLINK, &op, &org);
-}
-
-static TEEC_Result fs_trunc(TEEC_Session *sess, uint32_t obj, uint32_t len)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-	op.params[0].value.b = len;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_TRUNC, &op, &org);
-}
-
-static TEEC_Result _fs_rename(TEEC_Session *sess, uint32_t obj, void *id,
-			     uint32_t id_size)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-	op.params[1].tmpref.buffer = id;
-	op.params[1].tmpref.size = id_size;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT,
-					 TEEC_MEMREF_TEMP_INPUT, TEEC_NONE,
-					 TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_RENAME, &op, &org);
-}
-
-static TEEC_Result fs_alloc_enum(TEEC_Session *sess, uint32_t *e)
-{
-	TEEC_Result res = TEEC_ERROR_GENERIC;
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_OUTPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	res = TEEC_InvokeCommand(sess, TA_STORAGE_CMD_ALLOC_ENUM, &op, &org);
-
-	if (res == TEEC_SUCCESS)
-		*e = op.params[0].value.a;
-
-	return res;
-}
-
-static TEEC_Result fs_reset_enum(TEEC_Session *sess, uint32_t e)
-{
-	TEEC_Result res = TEEC_ERROR_GENERIC;
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	op.params[0].value.a = e;
-	res = TEEC_InvokeCommand(sess, TA_STORAGE_CMD_RESET_ENUM, &op, &org);
-
-	return res;
-}
-
-static TEEC_Result fs_free_enum(TEEC_Session *sess, uint32_t e)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE, TEEC_NONE,
-					 TEEC_NONE);
-
-	op.params[0].value.a = e;
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_FREE_ENUM, &op, &org);
-}
-
-static TEEC_Result fs_start_enum(TEEC_Session *sess, uint32_t e,
-				 uint32_t storage_id)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	op.params[0].value.a = e;
-	op.params[0].value.b = storage_id;
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_START_ENUM, &op, &org);
-}
-
-static TEEC_Result fs_next_enum(TEEC_Session *sess, uint32_t e, void *obj_info,
-				size_t info_size, void *id, uint32_t id_size)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_MEMREF_TEMP_OUTPUT, TEEC_NONE);
-	if (obj_info && info_size)
-		op.paramTypes |= (TEEC_MEMREF_TEMP_OUTPUT << 4);
-
-	op.params[0].value.a = e;
-	op.params[1].tmpref.buffer = obj_info;
-	op.params[1].tmpref.size = info_size;
-	op.params[2].tmpref.buffer = id;
-	op.params[2].tmpref.size = id_size;
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_NEXT_ENUM, &op, &org);
-}
-
-static TEEC_Result fs_restrict_usage(TEEC_Session *sess, uint32_t obj,
-				     uint32_t obj_usage)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-	op.params[0].value.b = obj_usage;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_RESTRICT_USAGE,
-				  &op, &org);
-}
-
-static TEEC_Result fs_alloc_obj(TEEC_Session *sess, uint32_t obj_type,
-				     uint32_t max_key_size, uint32_t *obj)
-{
-	TEEC_Result res = TEEC_ERROR_GENERIC;
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj_type;
-	op.params[0].value.b = max_key_size;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_VALUE_OUTPUT,
-					 TEEC_NONE, TEEC_NONE);
-
-	res = TEEC_InvokeCommand(sess, TA_STORAGE_CMD_ALLOC_OBJ, &op, &org);
-	*obj = op.params[1].value.a;
-	return res;
-}
-
-static TEEC_Result fs_free_obj(TEEC_Session *sess, uint32_t obj)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_FREE_OBJ, &op, &org);
-}
-
-static TEEC_Result fs_reset_obj(TEEC_Session *sess, uint32_t obj)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.params[0].value.a = obj;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
-					 TEEC_NONE, TEEC_NONE);
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_RESET_OBJ, &op, &org);
-}
-
-static TEEC_Result fs_get_obj_info(TEEC_Session *sess, uint32_t obj,
-				void *obj_info, size_t info_size)
-{
-	TEEC_Operation op = TEEC_OPERATION_INITIALIZER;
-	uint32_t org = 0;
-
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT,
-					TEEC_MEMREF_TEMP_OUTPUT,
-					TEEC_NONE, TEEC_NONE);
-
-	op.params[0].value.a = obj;
-	op.params[1].tmpref.buffer = obj_info;
-	op.params[1].tmpref.size = info_size;
-
-	return TEEC_InvokeCommand(sess, TA_STORAGE_CMD_GET_OBJ_INFO, &op, &org);
-}
-
-/* Record availability of all secure storage types at runtime */
-struct storage_info {
-	uint32_t id;
-	bool available;
-};
-
-static struct storage_info storage_info[] = {
-	{ .id = TEE_STORAGE_PRIVATE },
-	{ .id = TEE_STORAGE_PRIVATE_REE },
-	{ .id = TEE_STORAGE_PRIVATE_RPMB },
-};
-
-static TEEC_Result check_storage_available(uint32_t id, bool *avail)
-{
-	TEE_Result res = TEEC_SUCCESS;
-	TEEC_Session sess = { };
-	uint32_t obj = 0;
-	uint32_t orig = 0;
-	char name[] = "xtest_storage_test";
-
-	res = xtest_teec_open_session(&sess, &storage_ta_uuid, NULL, &orig);
-	if (res != TEEC_SUCCESS)
-		return res;
-
-	res = fs_create(&sess, name, sizeof(name), TEE_DATA_FLAG_ACCESS_WRITE |
-			TEE_DATA_FLAG_ACCESS_READ |
-			TEE_DATA_FLAG_ACCESS_WRITE_META, 0, NULL, 0, &obj, id);
-	switch (res) {
-	case TEEC_SUCCESS:
-		*avail = true;
-		_fs_unlink(&sess, obj);
-		break;
-	case TEE_ERROR_ITEM_NOT_FOUND:
-	case TEE_ERROR_STORAGE_NOT_AVAILABLE:
-	case TEE_ERROR_STORAGE_NOT_AVAILABLE_2:
-		*avail = false;
-		res = TEEC_SUCCESS;
-		break;
-	default:
-		res = TEE_ERROR_GENERIC;
-		break;
-	}
-
-
-	TEEC_CloseSession(&sess);
-
-	return res;
-}
-
-static TEE_Result init_storage_info(void)
-{
-	TEE_Result res = TEE_SUCCESS;
-	static bool done = false;
-	size_t i = 0;
-
-	if (done)
-		return TEE_SUCCESS;
-
-	for (i = 0; i < ARRAY_SIZE(storage_info); i++) {
-		res = check_storage_available(storage_info[i].id,
-					      &storage_info[i].available);
-		if (res)
-			return res;
-	}
-	done = true;
-	return TEE_SUCCESS;
-}
-
-static bool is_storage_available(uint32_t id)
-{
-	size_t i = 0;
-
-	if (init_storage_info())
-		return false;
-
-	for (i = 0; i < ARRAY_SIZE(storage_info); i++) {
-		if (id == storage_info[i].id)
-			return storage_info[i].available;
-	}
-	return false;
-}
-
-#ifndef TEE_STORAGE_ILLEGAL_VALUE
-/* GP TEE Internal Core API >= 1.2 table 5-2 */
-#define TEE_STORAGE_ILLEGAL_VALUE 0x7FFFFFFF
-#endif
-
-static uint32_t fs_id_for_tee_storage_private(void)
-{
-	/*
-	 * Assumes that REE FS is preferred over RPMB FS at compile time in
-	 * optee_os
-	 */
-	if (is_storage_available(TEE_STORAGE_PRIVATE_REE))
-		return TEE_STORAGE_PRIVATE_REE;
-	if (is_storage_available(TEE_STORAGE_PRIVATE_RPMB))
-		return TEE_STORAGE_PRIVATE_RPMB;
-
-	return TEE_STORAGE_ILLEGAL_VALUE;
-}
-
-static uint32_t real_id_for(uint32_t id)
-{
-	if (id == TEE_STORAGE_PRIVATE)
-		return fs_id_for_tee_storage_private();
-	return id;
-}
-
-static bool storage_is(uint32_t id1, uint32_t id2)
-{
-	return (real_id_for(id1) == real_id_for(id2));
-}
-
 /* trunc */
 static void test_truncate_file_length(ADBG_Case_t *c, uint32_t storage_id)
 {
@@ -2348,4 +1889,41 @@ exit1:
 	ADBG_Assert(&c);
 }
 
+/*
+ * The hash tree self test is only built in OP-TEE with
+ * CFG_REE_FS_HTREE_TESTS=y, the pseudo TA rejects the command otherwise.
+ */
+ZTEST(regression_6000, test_6021)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session session = { };
+	uint32_t ret_orig = 0;
+	ADBG_STRUCT_DECLARE("Core FS hash tree self tests");
+
+	/* Pseudo TA is optional: warn and nicely exit if not found */
+	res = xtest_teec_open_session(&session, &pta_invoke_tests_ta_uuid, NULL,
+				      &ret_orig);
+	if (res == TEEC_ERROR_ITEM_NOT_FOUND) {
+		printk(" - 6021 -   skip test, pseudo TA not found");
+		return;
+	}
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, res)) {
+		ADBG_Assert(&c);
+		return;
+	}
+
+	res = TEEC_InvokeCommand(&session, PTA_INVOKE_TESTS_CMD_FS_HTREE, NULL,
+				 &ret_orig);
+	if (res == TEEC_ERROR_BAD_PARAMETERS ||
+	    res == TEEC_ERROR_NOT_SUPPORTED) {
+		printk(" - 6021 -   skip test, hash tree tests not built in the TEE");
+		goto out;
+	}
+	ADBG_EXPECT_TEEC_SUCCESS(&c, res);
+
+out:
+	TEEC_CloseSession(&session);
+	ADBG_Assert(&c);
+}
+
 ZTEST_SUITE(regression_6000, NULL, regression_6000_init, NULL, NULL, regression_6000_deinit);
@@ -0,0 +1,1330 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <zephyr/fs/fs.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+#include <adbg.h>
+#include "optee_test.h"
+#include "storage_helpers.h"
+#include "xtest_benchmark.h"
+#include "xtest_helpers.h"
+#ifdef CONFIG_XTEST_RAMFS
+#include "xtest_ramfs.h"
+#endif
+
+#include <tee_client_api.h>
+#include <ta_storage.h>
+#include <tee_api_defines.h>
+#include <tee_api_defines_extensions.h>
+#include <tee_api_types.h>
+
+extern TEEC_Context xtest_teec_ctx;
+
+void *storage_benchmark_init(void)
+{
+	printk("Begin Test suite storage_benchmark\n");
+	(void)TEEC_InitializeContext(NULL, &xtest_teec_ctx);
+	return NULL;
+}
+
+void storage_benchmark_deinit(void *param)
+{
+	(void)param;
+	printk("End Test suite storage_benchmark\n");
+	TEEC_FinalizeContext(&xtest_teec_ctx);
+}
+
+/*
+ * Run @bench once per available storage backend. TEE_STORAGE_PRIVATE is
+ * an alias of one of them and is skipped.
+ */
+typedef void (*storage_bench_t)(ADBG_Case_t *c, uint32_t storage_id);
+
+static void run_on_backends(ADBG_Case_t *c, storage_bench_t bench,
+			    bool ree_only)
+{
+	size_t i = 0;
+
+	for (i = 0; i < ARRAY_SIZE(storage_info); i++) {
+		uint32_t id = storage_info[i].id;
+
+		if (id == TEE_STORAGE_PRIVATE || !storage_info[i].available)
+			continue;
+		if (ree_only && id != TEE_STORAGE_PRIVATE_REE)
+			continue;
+
+		Do_ADBG_BeginSubCase(c, "Storage id: %08x", id);
+		bench(c, id);
+		Do_ADBG_EndSubCase(c, "Storage id: %08x", id);
+	}
+}
+
+/*
+ * With CONFIG_XTEST_RAMFS, the REE FS backend is run a second time with
+ * /tee moved to the RAM filesystem, so that the share of flash and
+ * filesystem cost shows next to the figures of the board filesystem.
+ */
+static void for_each_storage_backend(ADBG_Case_t *c, storage_bench_t bench)
+{
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, init_storage_info()))
+		return;
+
+#ifdef CONFIG_XTEST_RAMFS
+	if (xtest_ramfs_is_mounted()) {
+		Do_ADBG_BeginSubCase(c, "/tee on RAM filesystem");
+		run_on_backends(c, bench, false);
+		Do_ADBG_EndSubCase(c, "/tee on RAM filesystem");
+		return;
+	}
+
+	Do_ADBG_BeginSubCase(c, "/tee on board filesystem");
+	run_on_backends(c, bench, false);
+	Do_ADBG_EndSubCase(c, "/tee on board filesystem");
+
+	Do_ADBG_BeginSubCase(c, "/tee on RAM filesystem");
+	if (ADBG_EXPECT(c, 0, xtest_ramfs_mount_tee())) {
+		run_on_backends(c, bench, true);
+		ADBG_EXPECT(c, 0, xtest_ramfs_unmount_tee());
+	}
+	Do_ADBG_EndSubCase(c, "/tee on RAM filesystem");
+#else
+	run_on_backends(c, bench, false);
+#endif
+}
+
+/*
+ * Persistent object enumeration scaling
+ *
+ * The object directory is grown by steps up to the last entry of
+ * enum_checkpoints[]. At each step a full enumeration is timed, as well as
+ * every TEE_GetNextPersistentObject() call and the opening of a sample of
+ * objects spread over the directory.
+ */
+#define ENUM_OPEN_SAMPLES	32
+#define ENUM_ID_SIZE		24
+
+static const size_t enum_checkpoints[] = { 10, 50, 100, 500, 1000, 5000 };
+
+static size_t enum_obj_id(char *id, size_t n)
+{
+	return snprintf(id, ENUM_ID_SIZE, "bench_enum_%05zu", n);
+}
+
+static void enum_scaling_bench(ADBG_Case_t *c, uint32_t storage_id)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session sess = { };
+	uint32_t orig = 0;
+	uint32_t obj = 0;
+	uint32_t e = TEE_HANDLE_NULL;
+	char id[ENUM_ID_SIZE] = { };
+	uint8_t found_id[TEE_OBJECT_ID_MAX_LEN] = { };
+	size_t max_objects = enum_checkpoints[ARRAY_SIZE(enum_checkpoints) - 1];
+	struct xtest_bench_stats next_stats = { };
+	struct xtest_bench_stats open_stats = { };
+	char label[48] = { };
+	size_t id_size = 0;
+	size_t created = 0;
+	size_t found = 0;
+	uint64_t total = 0;
+	uint64_t t = 0;
+	size_t cp = 0;
+	size_t n = 0;
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, xtest_teec_open_session(&sess,
+					&storage_ta_uuid, NULL, &orig)))
+		return;
+
+	/* Objects left by other tests are enumerated as well */
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&next_stats,
+						      2 * max_objects)) ||
+	    !ADBG_EXPECT(c, 0, xtest_bench_stats_init(&open_stats,
+						      ENUM_OPEN_SAMPLES)))
+		goto out;
+
+	for (cp = 0; cp < ARRAY_SIZE(enum_checkpoints); cp++) {
+		for (; created < enum_checkpoints[cp]; created++) {
+			id_size = enum_obj_id(id, created);
+			res = fs_create(&sess, id, id_size,
+					TEE_DATA_FLAG_ACCESS_READ |
+					TEE_DATA_FLAG_ACCESS_WRITE_META, 0,
+					NULL, 0, &obj, storage_id);
+			if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+				goto cleanup;
+
+			res = _fs_close(&sess, obj);
+			if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+				goto cleanup;
+		}
+
+		xtest_bench_stats_reset(&next_stats);
+		xtest_bench_stats_reset(&open_stats);
+
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, fs_alloc_enum(&sess, &e)))
+			goto cleanup;
+
+		found = 0;
+		total = xtest_bench_now_ns();
+		res = fs_start_enum(&sess, e, storage_id);
+		while (res == TEEC_SUCCESS) {
+			t = xtest_bench_now_ns();
+			res = fs_next_enum(&sess, e, NULL, 0, found_id,
+					   sizeof(found_id));
+			t = xtest_bench_now_ns() - t;
+			if (res != TEEC_SUCCESS)
+				break;
+
+			xtest_bench_stats_add(&next_stats, t);
+			found++;
+		}
+		total = xtest_bench_now_ns() - total;
+
+		ADBG_EXPECT_TEEC_RESULT(c, TEEC_ERROR_ITEM_NOT_FOUND, res);
+		ADBG_EXPECT_TEEC_SUCCESS(c, fs_free_enum(&sess, e));
+		if (!ADBG_EXPECT_COMPARE_UNSIGNED(c, found, >=, created))
+			goto cleanup;
+
+		for (n = 0; n < ENUM_OPEN_SAMPLES; n++) {
+			id_size = enum_obj_id(id, n * created /
+						  ENUM_OPEN_SAMPLES);
+
+			t = xtest_bench_now_ns();
+			res = _fs_open(&sess, id, id_size,
+				       TEE_DATA_FLAG_ACCESS_READ, &obj,
+				       storage_id);
+			t = xtest_bench_now_ns() - t;
+			if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+				goto cleanup;
+
+			xtest_bench_stats_add(&open_stats, t);
+
+			res = _fs_close(&sess, obj);
+			if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+				goto cleanup;
+		}
+
+		printk("    %zu objects: full enumeration " XTEST_BENCH_US_FMT
+		       " us, %zu found\n", created, XTEST_BENCH_US(total),
+		       found);
+		snprintf(label, sizeof(label), "%zu objects next_enum",
+			 created);
+		xtest_bench_stats_print(label, &next_stats);
+		snprintf(label, sizeof(label), "%zu objects open by ID",
+			 created);
+		xtest_bench_stats_print(label, &open_stats);
+	}
+
+cleanup:
+	for (n = 0; n < created; n++) {
+		id_size = enum_obj_id(id, n);
+		res = _fs_open(&sess, id, id_size,
+			       TEE_DATA_FLAG_ACCESS_READ |
+			       TEE_DATA_FLAG_ACCESS_WRITE_META, &obj,
+			       storage_id);
+		if (ADBG_EXPECT_TEEC_SUCCESS(c, res))
+			ADBG_EXPECT_TEEC_SUCCESS(c, _fs_unlink(&sess, obj));
+	}
+out:
+	xtest_bench_stats_free(&open_stats);
+	xtest_bench_stats_free(&next_stats);
+	TEEC_CloseSession(&sess);
+}
+
+ZTEST(storage_benchmark, test_6001)
+{
+	ADBG_STRUCT_DECLARE("Persistent object enumeration scaling");
+
+	for_each_storage_backend(&c, enum_scaling_bench);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Large object streaming
+ *
+ * Objects of several MiB are written then read back sequentially, with
+ * chunks of various sizes taken from a heap buffer. Combinations needing
+ * more than STREAM_MAX_CALLS TA invocations per direction are skipped to
+ * keep the run time bounded. On the REE FS, object sizes that cannot fit
+ * in the free space of /tee are skipped along with the larger ones; a
+ * TEE_ERROR_STORAGE_NO_SPACE write does the same on other backends.
+ */
+#define STREAM_MAX_CALLS	8192
+#define STREAM_TEE_DIR		"/tee"
+
+static const size_t stream_object_sizes[] = {
+	1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024,
+};
+
+static const size_t stream_chunk_sizes[] = {
+	512, 4 * 1024, 32 * 1024, 256 * 1024,
+};
+
+static uint8_t stream_obj_id[] = "bench_stream";
+
+/*
+ * The REE FS keeps an A and a B version of each block and hash tree node,
+ * so an object needs about twice its size, plus its hash tree and the
+ * directory file.
+ */
+static bool stream_fits(uint32_t storage_id, size_t obj_size)
+{
+	struct fs_statvfs stat = { };
+	uint64_t need = 2 * (uint64_t)obj_size + obj_size / 16 + 64 * 1024;
+
+	if (storage_id != TEE_STORAGE_PRIVATE_REE)
+		return true;
+
+	/* Free space unknown, only the write error tells */
+	if (fs_statvfs(STREAM_TEE_DIR, &stat))
+		return true;
+
+	return (uint64_t)stat.f_bfree * stat.f_frsize >= need;
+}
+
+static TEEC_Result stream_one(ADBG_Case_t *c, TEEC_Session *sess,
+			      uint32_t storage_id, uint8_t *buf,
+			      size_t obj_size, size_t chunk)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint32_t obj = 0;
+	uint32_t count = 0;
+	char label[48] = { };
+	uint64_t t = 0;
+	size_t off = 0;
+
+	res = fs_create(sess, stream_obj_id, sizeof(stream_obj_id),
+			TEE_DATA_FLAG_ACCESS_READ | TEE_DATA_FLAG_ACCESS_WRITE |
+			TEE_DATA_FLAG_ACCESS_WRITE_META |
+			TEE_DATA_FLAG_OVERWRITE, 0, NULL, 0, &obj, storage_id);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		return res;
+
+	t = xtest_bench_now_ns();
+	for (off = 0; off < obj_size; off += chunk) {
+		buf[0] = off / chunk;
+		res = _fs_write(sess, obj, buf, chunk);
+		if (res == TEE_ERROR_STORAGE_NO_SPACE)
+			goto unlink;
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+			goto unlink;
+	}
+	t = xtest_bench_now_ns() - t;
+
+	snprintf(label, sizeof(label), "%zu MiB object, %zu B chunks write",
+		 obj_size / (1024 * 1024), chunk);
+	xtest_bench_print_mib(label, obj_size, t);
+
+	res = _fs_seek(sess, obj, 0, TEE_DATA_SEEK_SET);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		goto unlink;
+
+	t = xtest_bench_now_ns();
+	for (off = 0; off < obj_size; off += chunk) {
+		res = _fs_read(sess, obj, buf, chunk, &count);
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, res) ||
+		    !ADBG_EXPECT_COMPARE_UNSIGNED(c, count, ==, chunk) ||
+		    !ADBG_EXPECT_COMPARE_UNSIGNED(c, buf[0], ==,
+						  (uint8_t)(off / chunk))) {
+			res = TEEC_ERROR_GENERIC;
+			goto unlink;
+		}
+	}
+	t = xtest_bench_now_ns() - t;
+
+	snprintf(label, sizeof(label), "%zu MiB object, %zu B chunks read",
+		 obj_size / (1024 * 1024), chunk);
+	xtest_bench_print_mib(label, obj_size, t);
+
+unlink:
+	ADBG_EXPECT_TEEC_SUCCESS(c, _fs_unlink(sess, obj));
+	return res;
+}
+
+static void stream_bench(ADBG_Case_t *c, uint32_t storage_id)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session sess = { };
+	uint32_t orig = 0;
+	size_t max_chunk = stream_chunk_sizes[ARRAY_SIZE(stream_chunk_sizes) - 1];
+	uint8_t *buf = NULL;
+	size_t s = 0;
+	size_t n = 0;
+
+	buf = k_malloc(max_chunk);
+	if (!ADBG_EXPECT_NOT_NULL(c, buf))
+		return;
+	memset(buf, 0xa5, max_chunk);
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, xtest_teec_open_session(&sess,
+					&storage_ta_uuid, NULL, &orig)))
+		goto out;
+
+	for (s = 0; s < ARRAY_SIZE(stream_object_sizes); s++) {
+		if (!stream_fits(storage_id, stream_object_sizes[s])) {
+			Do_ADBG_Log("    %zu MiB object: not enough free space on %s, larger objects skipped",
+				    stream_object_sizes[s] / (1024 * 1024),
+				    STREAM_TEE_DIR);
+			break;
+		}
+
+		for (n = 0; n < ARRAY_SIZE(stream_chunk_sizes); n++) {
+			if (stream_object_sizes[s] / stream_chunk_sizes[n] >
+			    STREAM_MAX_CALLS)
+				continue;
+
+			res = stream_one(c, &sess, storage_id, buf,
+					 stream_object_sizes[s],
+					 stream_chunk_sizes[n]);
+			if (res == TEE_ERROR_STORAGE_NO_SPACE) {
+				Do_ADBG_Log("    %zu MiB object: no space left, larger objects skipped",
+					    stream_object_sizes[s] /
+					    (1024 * 1024));
+				goto close_session;
+			}
+			if (res != TEEC_SUCCESS)
+				goto close_session;
+		}
+	}
+
+close_session:
+	TEEC_CloseSession(&sess);
+out:
+	k_free(buf);
+}
+
+ZTEST(storage_benchmark, test_6002)
+{
+	ADBG_STRUCT_DECLARE("Large object streaming throughput");
+
+	for_each_storage_backend(&c, stream_bench);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Random access latency
+ *
+ * A large object is built once, then read with seek + read pairs of
+ * various sizes following a sequential, a strided and a (seeded, so
+ * repeatable) random offset pattern. Each pair is one operation in the
+ * reported latency, histogram and IOPS.
+ */
+#define RA_OBJECT_SIZE		(2 * 1024 * 1024)
+#define RA_WRITE_CHUNK		(64 * 1024)
+#define RA_OPS			256
+#define RA_STRIDE		(64 * 1024)
+#define RA_SEED			0x2545f491
+
+static const size_t ra_read_sizes[] = { 16, 256, 4 * 1024, 64 * 1024 };
+
+enum ra_pattern {
+	RA_SEQUENTIAL,
+	RA_STRIDED,
+	RA_RANDOM,
+};
+
+static const char * const ra_pattern_names[] = {
+	[RA_SEQUENTIAL] = "sequential",
+	[RA_STRIDED] = "strided",
+	[RA_RANDOM] = "random",
+};
+
+static uint8_t ra_obj_id[] = "bench_random_access";
+
+/* Offset of the @n-th read of @size bytes */
+static size_t ra_offset(enum ra_pattern pattern, size_t n, size_t size,
+			uint32_t *seed)
+{
+	size_t span = RA_OBJECT_SIZE - size + 1;
+
+	switch (pattern) {
+	case RA_SEQUENTIAL:
+		return (n * size) % span;
+	case RA_STRIDED:
+		return (n * (size + RA_STRIDE)) % span;
+	default:
+		return xtest_bench_rand(seed) % span;
+	}
+}
+
+static void ra_bench(ADBG_Case_t *c, uint32_t storage_id)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session sess = { };
+	uint32_t orig = 0;
+	uint32_t obj = 0;
+	uint32_t count = 0;
+	uint32_t seed = RA_SEED;
+	struct xtest_bench_stats stats = { };
+	enum ra_pattern pattern = RA_SEQUENTIAL;
+	uint8_t *buf = NULL;
+	char label[48] = { };
+	size_t off = 0;
+	uint64_t t = 0;
+	size_t s = 0;
+	size_t n = 0;
+
+	buf = k_malloc(MAX(RA_WRITE_CHUNK,
+			   ra_read_sizes[ARRAY_SIZE(ra_read_sizes) - 1]));
+	if (!ADBG_EXPECT_NOT_NULL(c, buf))
+		return;
+
+	if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&stats, RA_OPS)))
+		goto out;
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, xtest_teec_open_session(&sess,
+					&storage_ta_uuid, NULL, &orig)))
+		goto out;
+
+	res = fs_create(&sess, ra_obj_id, sizeof(ra_obj_id),
+			TEE_DATA_FLAG_ACCESS_READ | TEE_DATA_FLAG_ACCESS_WRITE |
+			TEE_DATA_FLAG_ACCESS_WRITE_META |
+			TEE_DATA_FLAG_OVERWRITE, 0, NULL, 0, &obj, storage_id);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		goto close_session;
+
+	for (off = 0; off < RA_OBJECT_SIZE; off += RA_WRITE_CHUNK) {
+		memset(buf, off / RA_WRITE_CHUNK, RA_WRITE_CHUNK);
+		res = _fs_write(&sess, obj, buf, RA_WRITE_CHUNK);
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+			goto unlink;
+	}
+
+	for (pattern = RA_SEQUENTIAL; pattern <= RA_RANDOM; pattern++) {
+		for (s = 0; s < ARRAY_SIZE(ra_read_sizes); s++) {
+			xtest_bench_stats_reset(&stats);
+
+			for (n = 0; n < RA_OPS; n++) {
+				off = ra_offset(pattern, n, ra_read_sizes[s],
+						&seed);
+
+				t = xtest_bench_now_ns();
+				res = _fs_seek(&sess, obj, off,
+					       TEE_DATA_SEEK_SET);
+				if (res == TEEC_SUCCESS)
+					res = _fs_read(&sess, obj, buf,
+						       ra_read_sizes[s],
+						       &count);
+				t = xtest_bench_now_ns() - t;
+				if (!ADBG_EXPECT_TEEC_SUCCESS(c, res) ||
+				    !ADBG_EXPECT_COMPARE_UNSIGNED(c, count, ==,
+							ra_read_sizes[s]) ||
+				    !ADBG_EXPECT_COMPARE_UNSIGNED(c, buf[0], ==,
+						(uint8_t)(off / RA_WRITE_CHUNK)))
+					goto unlink;
+
+				xtest_bench_stats_add(&stats, t);
+			}
+
+			snprintf(label, sizeof(label), "%s %zu B reads",
+				 ra_pattern_names[pattern], ra_read_sizes[s]);
+			xtest_bench_stats_print(label, &stats);
+			xtest_bench_stats_histogram(&stats);
+		}
+	}
+
+unlink:
+	ADBG_EXPECT_TEEC_SUCCESS(c, _fs_unlink(&sess, obj));
+close_session:
+	TEEC_CloseSession(&sess);
+out:
+	xtest_bench_stats_free(&stats);
+	k_free(buf);
+}
+
+ZTEST(storage_benchmark, test_6003)
+{
+	ADBG_STRUCT_DECLARE("Random access seek/read latency");
+
+	for_each_storage_backend(&c, ra_bench);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Storage concurrency
+ *
+ * 1, 2, 4, ... threads up to CONFIG_XTEST_BENCHMARK_STORAGE_THREADS each
+ * open a storage TA session and run a mix of read, write and
+ * create/unlink operations on their own objects. Sessions either all go
+ * to the same storage TA or alternate between the two storage TAs.
+ * Aggregate throughput is computed over the span from the first thread
+ * start to the last thread end.
+ */
+#define CONC_THREADS		CONFIG_XTEST_BENCHMARK_STORAGE_THREADS
+#define CONC_OBJECT_SIZE	CONFIG_XTEST_BENCHMARK_STORAGE_OBJECT_SIZE
+#define CONC_OPS		CONFIG_XTEST_BENCHMARK_STORAGE_OPS
+#define CONC_READ_PERCENT	CONFIG_XTEST_BENCHMARK_STORAGE_READ_PERCENT
+#define CONC_WRITE_PERCENT	CONFIG_XTEST_BENCHMARK_STORAGE_WRITE_PERCENT
+#define CONC_STACK_SIZE		(4096 + CONFIG_TEST_EXTRA_STACK_SIZE)
+
+K_THREAD_STACK_ARRAY_DEFINE(conc_stacks, CONC_THREADS, CONC_STACK_SIZE);
+
+struct conc_thread_arg {
+	ADBG_Case_t *case_t;
+	TEEC_Session session;
+	bool storage2;
+	uint32_t storage_id;
+	size_t index;
+	uint8_t *buf;
+	struct xtest_bench_stats stats;
+	/* Status of the timed loop, start_ns and end_ns are set on success */
+	TEEC_Result res;
+	uint64_t start_ns;
+	uint64_t end_ns;
+};
+
+static struct conc_thread_arg conc_args[CONC_THREADS];
+
+static TEEC_Result conc_run_op(struct conc_thread_arg *a, uint32_t op,
+			       char *name, size_t name_size, char *tmp_name,
+			       size_t tmp_name_size)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint32_t count = 0;
+	uint32_t obj = 0;
+
+	if (op < CONC_READ_PERCENT) {
+		res = _fs_open(&a->session, name, name_size,
+			       TEE_DATA_FLAG_ACCESS_READ |
+			       TEE_DATA_FLAG_SHARE_READ, &obj, a->storage_id);
+		if (res != TEEC_SUCCESS)
+			return res;
+
+		res = _fs_read(&a->session, obj, a->buf, CONC_OBJECT_SIZE,
+			       &count);
+		if (res == TEEC_SUCCESS && count != CONC_OBJECT_SIZE)
+			res = TEEC_ERROR_GENERIC;
+		_fs_close(&a->session, obj);
+	} else if (op < CONC_READ_PERCENT + CONC_WRITE_PERCENT) {
+		res = _fs_open(&a->session, name, name_size,
+			       TEE_DATA_FLAG_ACCESS_WRITE, &obj,
+			       a->storage_id);
+		if (res != TEEC_SUCCESS)
+			return res;
+
+		res = _fs_write(&a->session, obj, a->buf, CONC_OBJECT_SIZE);
+		_fs_close(&a->session, obj);
+	} else {
+		res = fs_create(&a->session, tmp_name, tmp_name_size,
+				TEE_DATA_FLAG_ACCESS_WRITE_META, 0, a->buf,
+				CONC_OBJECT_SIZE, &obj, a->storage_id);
+		if (res != TEEC_SUCCESS)
+			return res;
+
+		res = _fs_unlink(&a->session, obj);
+	}
+
+	return res;
+}
+
+static void *conc_thread(void *arg)
+{
+	struct conc_thread_arg *a = arg;
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint32_t seed = RA_SEED + a->index;
+	char name[16] = { };
+	char tmp_name[16] = { };
+	size_t name_size = 0;
+	size_t tmp_name_size = 0;
+	uint32_t obj = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	name_size = snprintf(name, sizeof(name), "conc_%zu", a->index);
+	tmp_name_size = snprintf(tmp_name, sizeof(tmp_name), "conc_tmp_%zu",
+				 a->index);
+
+	res = fs_create(&a->session, name, name_size,
+			TEE_DATA_FLAG_ACCESS_WRITE |
+			TEE_DATA_FLAG_OVERWRITE, 0, a->buf, CONC_OBJECT_SIZE,
+			&obj, a->storage_id);
+	a->res = res;
+	if (!ADBG_EXPECT_TEEC_SUCCESS(a->case_t, res))
+		return NULL;
+	_fs_close(&a->session, obj);
+
+	a->start_ns = xtest_bench_now_ns();
+	for (n = 0; n < CONC_OPS; n++) {
+		t = xtest_bench_now_ns();
+		res = conc_run_op(a, xtest_bench_rand(&seed) % 100, name,
+				  name_size, tmp_name, tmp_name_size);
+		t = xtest_bench_now_ns() - t;
+		if (!ADBG_EXPECT_TEEC_SUCCESS(a->case_t, res))
+			break;
+
+		xtest_bench_stats_add(&a->stats, t);
+	}
+	a->end_ns = xtest_bench_now_ns();
+	a->res = res;
+
+	res = _fs_open(&a->session, name, name_size,
+		       TEE_DATA_FLAG_ACCESS_WRITE_META, &obj, a->storage_id);
+	if (ADBG_EXPECT_TEEC_SUCCESS(a->case_t, res))
+		ADBG_EXPECT_TEEC_SUCCESS(a->case_t,
+					 _fs_unlink(&a->session, obj));
+
+	return NULL;
+}
+
+static void conc_run(ADBG_Case_t *c, uint32_t storage_id, size_t nb_threads,
+		     bool two_tas)
+{
+	pthread_attr_t attr = { };
+	pthread_t thr[CONC_THREADS] = { };
+	uint32_t orig = 0;
+	bool failed = false;
+	int rc = 0;
+	uint64_t first_start = UINT64_MAX;
+	uint64_t last_end = 0;
+	uint64_t total_ops = 0;
+	char label[48] = { };
+	size_t i = 0;
+	size_t m = 0;
+	size_t n = 0;
+
+	memset(conc_args, 0, sizeof(conc_args));
+
+	for (m = 0; m < nb_threads; m++) {
+		struct conc_thread_arg *a = conc_args + m;
+
+		a->case_t = c;
+		a->storage_id = storage_id;
+		a->index = m;
+		a->storage2 = two_tas && (m & 1);
+		a->buf = k_malloc(CONC_OBJECT_SIZE);
+		if (!ADBG_EXPECT_NOT_NULL(c, a->buf))
+			goto out;
+		memset(a->buf, m, CONC_OBJECT_SIZE);
+
+		if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(&a->stats,
+							      CONC_OPS)) ||
+		    !ADBG_EXPECT_TEEC_SUCCESS(c, xtest_teec_open_session(
+				&a->session, a->storage2 ? &storage2_ta_uuid :
+				&storage_ta_uuid, NULL, &orig))) {
+			k_free(a->buf);
+			xtest_bench_stats_free(&a->stats);
+			goto out;
+		}
+	}
+
+	for (n = 0; n < nb_threads; n++) {
+		if (!ADBG_EXPECT(c, 0, pthread_attr_init(&attr)))
+			goto out;
+
+		rc = pthread_attr_setstack(&attr, &conc_stacks[n][0],
+					   CONC_STACK_SIZE);
+		if (!rc)
+			rc = pthread_create(thr + n, &attr, conc_thread,
+					    conc_args + n);
+		pthread_attr_destroy(&attr);
+		if (!ADBG_EXPECT(c, 0, rc))
+			goto out;
+	}
+
+out:
+	for (i = 0; i < n; i++) {
+		ADBG_EXPECT(c, 0, pthread_join(thr[i], NULL));
+		if (conc_args[i].res != TEEC_SUCCESS)
+			failed = true;
+	}
+
+	/* A failed thread has no valid timing, the aggregate would be wrong */
+	if (n == nb_threads && failed) {
+		Do_ADBG_Log("    %zu threads: a thread failed, no aggregate",
+			    nb_threads);
+	} else if (n == nb_threads) {
+		for (i = 0; i < n; i++) {
+			first_start = MIN(first_start, conc_args[i].start_ns);
+			last_end = MAX(last_end, conc_args[i].end_ns);
+			total_ops += conc_args[i].stats.count;
+		}
+
+		printk("    %zu threads: %" PRIu64 " ops in " XTEST_BENCH_US_FMT
+		       " us, " XTEST_BENCH_MILLI_FMT " op/s aggregate\n",
+		       nb_threads, total_ops,
+		       XTEST_BENCH_US(last_end - first_start),
+		       XTEST_BENCH_MILLI(xtest_bench_rate_milli(total_ops,
+						last_end - first_start)));
+
+		for (i = 0; i < n; i++) {
+			snprintf(label, sizeof(label), "  thread %zu%s", i,
+				 conc_args[i].storage2 ? " (storage2 TA)" : "");
+			xtest_bench_stats_print(label, &conc_args[i].stats);
+		}
+	}
+
+	for (i = 0; i < m; i++) {
+		TEEC_CloseSession(&conc_args[i].session);
+		xtest_bench_stats_free(&conc_args[i].stats);
+		k_free(conc_args[i].buf);
+	}
+}
+
+static void conc_bench(ADBG_Case_t *c, uint32_t storage_id)
+{
+	size_t nb_threads = 0;
+	int two_tas = 0;
+
+	for (two_tas = 0; two_tas <= 1; two_tas++) {
+		Do_ADBG_BeginSubCase(c, "%s",
+				     two_tas ? "Alternating storage TAs" :
+					       "Single storage TA");
+
+		for (nb_threads = 1; nb_threads <= CONC_THREADS;
+		     nb_threads *= 2)
+			conc_run(c, storage_id, nb_threads, two_tas);
+
+		/* Not a power of two */
+		if (nb_threads / 2 != CONC_THREADS)
+			conc_run(c, storage_id, CONC_THREADS, two_tas);
+
+		Do_ADBG_EndSubCase(c, "%s",
+				   two_tas ? "Alternating storage TAs" :
+					     "Single storage TA");
+	}
+}
+
+ZTEST(storage_benchmark, test_6004)
+{
+	ADBG_STRUCT_DECLARE("Storage concurrency scaling");
+
+	BUILD_ASSERT(CONC_READ_PERCENT + CONC_WRITE_PERCENT <= 100,
+		     "Read and write shares exceed 100%");
+
+	Do_ADBG_Log("    %d operations per thread on %d byte objects, %d%% read, %d%% write",
+		    CONC_OPS, CONC_OBJECT_SIZE, CONC_READ_PERCENT,
+		    CONC_WRITE_PERCENT);
+	for_each_storage_backend(&c, conc_bench);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Persistent object lifecycle
+ *
+ * Small objects go through create, close, open, rename, truncate and
+ * unlink in a tight loop, each call timed on its own. In the cold state
+ * no other object is open, so OP-TEE opens the REE FS directory file
+ * again for each first handle; in the warm state an anchor object is
+ * kept open for the whole loop, which keeps the directory file open.
+ *
+ * Enough iterations are run for the reported p99 to sit five samples
+ * below the maximum.
+ */
+#define LC_ITERATIONS		512
+#define LC_ID_SIZE		24
+#define LC_MAX_SIZE		(4 * 1024)
+
+enum lc_op {
+	LC_CREATE,
+	LC_CLOSE,
+	LC_OPEN,
+	LC_RENAME,
+	LC_TRUNC,
+	LC_UNLINK,
+	LC_OP_COUNT,
+};
+
+static const char * const lc_op_names[] = {
+	[LC_CREATE] = "create",
+	[LC_CLOSE] = "close",
+	[LC_OPEN] = "open",
+	[LC_RENAME] = "rename",
+	[LC_TRUNC] = "truncate",
+	[LC_UNLINK] = "unlink",
+};
+
+static const size_t lc_object_sizes[] = { 0, 256, 1024, LC_MAX_SIZE };
+
+static uint8_t lc_anchor_id[] = "bench_lc_anchor";
+
+/* Runs one lifecycle, @obj is left open on error */
+static TEEC_Result lc_one(TEEC_Session *sess, uint32_t storage_id,
+			  uint8_t *buf, size_t size, size_t n,
+			  struct xtest_bench_stats *stats, uint32_t *obj)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	char id[LC_ID_SIZE] = { };
+	char new_id[LC_ID_SIZE] = { };
+	size_t id_size = 0;
+	size_t new_id_size = 0;
+	uint64_t t = 0;
+
+	id_size = snprintf(id, sizeof(id), "bench_lc_%04zu", n);
+	new_id_size = snprintf(new_id, sizeof(new_id), "bench_lc_r_%04zu", n);
+
+	t = xtest_bench_now_ns();
+	res = fs_create(sess, id, id_size, TEE_DATA_FLAG_ACCESS_READ |
+			TEE_DATA_FLAG_ACCESS_WRITE |
+			TEE_DATA_FLAG_ACCESS_WRITE_META |
+			TEE_DATA_FLAG_OVERWRITE, 0, buf, size, obj,
+			storage_id);
+	xtest_bench_stats_add(stats + LC_CREATE, xtest_bench_now_ns() - t);
+	if (res != TEEC_SUCCESS)
+		return res;
+
+	t = xtest_bench_now_ns();
+	res = _fs_close(sess, *obj);
+	xtest_bench_stats_add(stats + LC_CLOSE, xtest_bench_now_ns() - t);
+	if (res != TEEC_SUCCESS)
+		return res;
+	*obj = 0;
+
+	t = xtest_bench_now_ns();
+	res = _fs_open(sess, id, id_size, TEE_DATA_FLAG_ACCESS_READ |
+		       TEE_DATA_FLAG_ACCESS_WRITE |
+		       TEE_DATA_FLAG_ACCESS_WRITE_META, obj, storage_id);
+	xtest_bench_stats_add(stats + LC_OPEN, xtest_bench_now_ns() - t);
+	if (res != TEEC_SUCCESS)
+		return res;
+
+	t = xtest_bench_now_ns();
+	res = _fs_rename(sess, *obj, new_id, new_id_size);
+	xtest_bench_stats_add(stats + LC_RENAME, xtest_bench_now_ns() - t);
+	if (res != TEEC_SUCCESS)
+		return res;
+
+	t = xtest_bench_now_ns();
+	res = fs_trunc(sess, *obj, size / 2);
+	xtest_bench_stats_add(stats + LC_TRUNC, xtest_bench_now_ns() - t);
+	if (res != TEEC_SUCCESS)
+		return res;
+
+	t = xtest_bench_now_ns();
+	res = _fs_unlink(sess, *obj);
+	xtest_bench_stats_add(stats + LC_UNLINK, xtest_bench_now_ns() - t);
+	if (res != TEEC_SUCCESS)
+		return res;
+	*obj = 0;
+
+	return TEEC_SUCCESS;
+}
+
+static void lc_run(ADBG_Case_t *c, TEEC_Session *sess, uint32_t storage_id,
+		   uint8_t *buf, bool warm, struct xtest_bench_stats *stats)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint32_t anchor = 0;
+	uint32_t obj = 0;
+	char label[48] = { };
+	size_t s = 0;
+	size_t n = 0;
+	size_t i = 0;
+
+	if (warm) {
+		res = fs_create(sess, lc_anchor_id, sizeof(lc_anchor_id),
+				TEE_DATA_FLAG_ACCESS_WRITE_META |
+				TEE_DATA_FLAG_OVERWRITE, 0, NULL, 0, &anchor,
+				storage_id);
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+			return;
+	}
+
+	for (s = 0; s < ARRAY_SIZE(lc_object_sizes); s++) {
+		for (i = 0; i < LC_OP_COUNT; i++)
+			xtest_bench_stats_reset(stats + i);
+
+		for (n = 0; n < LC_ITERATIONS; n++) {
+			res = lc_one(sess, storage_id, buf, lc_object_sizes[s],
+				     n, stats, &obj);
+			if (!ADBG_EXPECT_TEEC_SUCCESS(c, res)) {
+				if (obj)
+					_fs_unlink(sess, obj);
+				goto out;
+			}
+		}
+
+		for (i = 0; i < LC_OP_COUNT; i++) {
+			snprintf(label, sizeof(label), "%zu B %s (%s)",
+				 lc_object_sizes[s], lc_op_names[i],
+				 warm ? "warm" : "cold");
+			xtest_bench_stats_print(label, stats + i);
+		}
+	}
+
+out:
+	if (anchor)
+		ADBG_EXPECT_TEEC_SUCCESS(c, _fs_unlink(sess, anchor));
+}
+
+static void lc_bench(ADBG_Case_t *c, uint32_t storage_id)
+{
+	struct xtest_bench_stats stats[LC_OP_COUNT] = { };
+	TEEC_Session sess = { };
+	uint32_t orig = 0;
+	uint8_t *buf = NULL;
+	size_t i = 0;
+
+	buf = k_malloc(LC_MAX_SIZE);
+	if (!ADBG_EXPECT_NOT_NULL(c, buf))
+		return;
+	memset(buf, 0x5a, LC_MAX_SIZE);
+
+	for (i = 0; i < LC_OP_COUNT; i++) {
+		if (!ADBG_EXPECT(c, 0, xtest_bench_stats_init(stats + i,
+							      LC_ITERATIONS)))
+			goto out;
+	}
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, xtest_teec_open_session(&sess,
+					&storage_ta_uuid, NULL, &orig)))
+		goto out;
+
+	lc_run(c, &sess, storage_id, buf, false, stats);
+	lc_run(c, &sess, storage_id, buf, true, stats);
+
+	TEEC_CloseSession(&sess);
+out:
+	for (i = 0; i < LC_OP_COUNT; i++)
+		xtest_bench_stats_free(stats + i);
+	k_free(buf);
+}
+
+ZTEST(storage_benchmark, test_6005)
+{
+	ADBG_STRUCT_DECLARE("Persistent object lifecycle operations");
+
+	for_each_storage_backend(&c, lc_bench);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Hash tree self test timing
+ *
+ * Runs the OP-TEE hash tree self test (PTA_INVOKE_TESTS_CMD_FS_HTREE, see
+ * regression_6000 test_6021) HTREE_RUNS times. The test works on an
+ * in-memory backend inside the TEE, so the figures are a hash tree
+ * baseline with no REE filesystem I/O.
+ */
+#define HTREE_RUNS		16
+
+ZTEST(storage_benchmark, test_6006)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	TEEC_Session session = { };
+	struct xtest_bench_stats stats = { };
+	uint32_t ret_orig = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+	ADBG_STRUCT_DECLARE("Hash tree self test timing");
+
+	res = xtest_teec_open_session(&session, &pta_invoke_tests_ta_uuid, NULL,
+				      &ret_orig);
+	if (res == TEEC_ERROR_ITEM_NOT_FOUND) {
+		printk(" - 6006 -   skip test, pseudo TA not found");
+		return;
+	}
+	if (!ADBG_EXPECT_TEEC_SUCCESS(&c, res))
+		goto out;
+
+	if (!ADBG_EXPECT(&c, 0, xtest_bench_stats_init(&stats, HTREE_RUNS)))
+		goto close_session;
+
+	for (n = 0; n < HTREE_RUNS; n++) {
+		t = xtest_bench_now_ns();
+		res = TEEC_InvokeCommand(&session,
+					 PTA_INVOKE_TESTS_CMD_FS_HTREE, NULL,
+					 &ret_orig);
+		t = xtest_bench_now_ns() - t;
+		if (res == TEEC_ERROR_BAD_PARAMETERS ||
+		    res == TEEC_ERROR_NOT_SUPPORTED) {
+			printk(" - 6006 -   skip test, hash tree tests not built in the TEE");
+			goto close_session;
+		}
+		if (!ADBG_EXPECT_TEEC_SUCCESS(&c, res))
+			goto close_session;
+
+		xtest_bench_stats_add(&stats, t);
+	}
+
+	xtest_bench_stats_print("hash tree self test", &stats);
+	xtest_bench_stats_histogram(&stats);
+
+close_session:
+	TEEC_CloseSession(&session);
+out:
+	xtest_bench_stats_free(&stats);
+	ADBG_Assert(&c);
+}
+
+/*
+ * Storage aging
+ *
+ * A pool of objects goes through rounds of randomized (seeded, so
+ * repeatable) churn: creation, extension, truncation and deletion of
+ * randomly picked objects. Before the first round and after every round,
+ * fixed probes time the sequential write and read of a probe object and
+ * a full enumeration, which gives the degradation curve of the storage
+ * as churn accumulates.
+ */
+#define AGE_POOL		64
+#define AGE_ROUNDS		CONFIG_XTEST_BENCHMARK_STORAGE_AGING_ROUNDS
+#define AGE_OPS			CONFIG_XTEST_BENCHMARK_STORAGE_AGING_OPS
+#define AGE_MAX_OBJECT_SIZE	(32 * 1024)
+#define AGE_MAX_CHUNK		(4 * 1024)
+#define AGE_PROBE_SIZE		(256 * 1024)
+#define AGE_PROBE_CHUNK		(16 * 1024)
+#define AGE_ID_SIZE		16
+#define AGE_SEED		0x6d2b79f5
+
+enum age_op {
+	AGE_CREATE,
+	AGE_EXTEND,
+	AGE_TRUNCATE,
+	AGE_DELETE,
+	AGE_OP_COUNT,
+};
+
+struct age_state {
+	TEEC_Session *sess;
+	uint32_t storage_id;
+	uint32_t seed;
+	uint8_t *buf;
+	bool live[AGE_POOL];
+	size_t sizes[AGE_POOL];
+	size_t ops[AGE_OP_COUNT];
+};
+
+/* Operations on a live object, extensions are twice as likely */
+static const enum age_op age_live_ops[] = {
+	AGE_EXTEND, AGE_EXTEND, AGE_TRUNCATE, AGE_DELETE,
+};
+
+static uint8_t age_probe_id[] = "bench_age_probe";
+
+static TEEC_Result age_open(struct age_state *st, size_t n, bool create,
+			    size_t len, uint32_t *obj)
+{
+	uint32_t flags = TEE_DATA_FLAG_ACCESS_READ |
+			 TEE_DATA_FLAG_ACCESS_WRITE |
+			 TEE_DATA_FLAG_ACCESS_WRITE_META;
+	char id[AGE_ID_SIZE] = { };
+	size_t id_size = snprintf(id, sizeof(id), "bench_age_%03zu", n);
+
+	if (create)
+		return fs_create(st->sess, id, id_size,
+				 flags | TEE_DATA_FLAG_OVERWRITE, 0, st->buf,
+				 len, obj, st->storage_id);
+
+	return _fs_open(st->sess, id, id_size, flags, obj, st->storage_id);
+}
+
+static TEEC_Result age_churn_one(struct age_state *st)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	size_t n = xtest_bench_rand(&st->seed) % AGE_POOL;
+	uint32_t r = xtest_bench_rand(&st->seed);
+	enum age_op op = AGE_CREATE;
+	uint32_t obj = 0;
+	size_t len = 0;
+
+	if (st->live[n]) {
+		op = age_live_ops[r % ARRAY_SIZE(age_live_ops)];
+		if (op == AGE_EXTEND &&
+		    st->sizes[n] + AGE_MAX_CHUNK > AGE_MAX_OBJECT_SIZE)
+			op = AGE_TRUNCATE;
+	}
+	r >>= 2;
+
+	if (op == AGE_CREATE)
+		len = r % (AGE_MAX_CHUNK + 1);
+	res = age_open(st, n, op == AGE_CREATE, len, &obj);
+	if (res != TEEC_SUCCESS)
+		return res;
+
+	switch (op) {
+	case AGE_CREATE:
+		st->live[n] = true;
+		st->sizes[n] = len;
+		break;
+	case AGE_EXTEND:
+		len = 1 + r % AGE_MAX_CHUNK;
+		res = _fs_seek(st->sess, obj, 0, TEE_DATA_SEEK_END);
+		if (res == TEEC_SUCCESS)
+			res = _fs_write(st->sess, obj, st->buf, len);
+		if (res == TEEC_SUCCESS)
+			st->sizes[n] += len;
+		break;
+	case AGE_TRUNCATE:
+		len = st->sizes[n] ? r % st->sizes[n] : 0;
+		res = fs_trunc(st->sess, obj, len);
+		if (res == TEEC_SUCCESS)
+			st->sizes[n] = len;
+		break;
+	default:
+		/* Closes the object */
+		res = _fs_unlink(st->sess, obj);
+		if (res == TEEC_SUCCESS) {
+			st->live[n] = false;
+			st->ops[op]++;
+		}
+		return res;
+	}
+
+	if (res == TEEC_SUCCESS) {
+		st->ops[op]++;
+		return _fs_close(st->sess, obj);
+	}
+
+	_fs_close(st->sess, obj);
+	return res;
+}
+
+static bool age_probe(ADBG_Case_t *c, struct age_state *st, size_t round)
+{
+	TEEC_Result res = TEEC_ERROR_GENERIC;
+	uint8_t found_id[TEE_OBJECT_ID_MAX_LEN] = { };
+	uint32_t e = TEE_HANDLE_NULL;
+	uint32_t obj = 0;
+	uint32_t count = 0;
+	uint64_t write_ns = 0;
+	uint64_t read_ns = 0;
+	uint64_t enum_ns = 0;
+	size_t found = 0;
+	size_t live = 0;
+	size_t off = 0;
+	size_t n = 0;
+
+	res = fs_create(st->sess, age_probe_id, sizeof(age_probe_id),
+			TEE_DATA_FLAG_ACCESS_READ | TEE_DATA_FLAG_ACCESS_WRITE |
+			TEE_DATA_FLAG_ACCESS_WRITE_META |
+			TEE_DATA_FLAG_OVERWRITE, 0, NULL, 0, &obj,
+			st->storage_id);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		return false;
+
+	write_ns = xtest_bench_now_ns();
+	for (off = 0; off < AGE_PROBE_SIZE; off += AGE_PROBE_CHUNK) {
+		res = _fs_write(st->sess, obj, st->buf, AGE_PROBE_CHUNK);
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+			goto unlink;
+	}
+	write_ns = xtest_bench_now_ns() - write_ns;
+
+	res = _fs_seek(st->sess, obj, 0, TEE_DATA_SEEK_SET);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		goto unlink;
+
+	read_ns = xtest_bench_now_ns();
+	for (off = 0; off < AGE_PROBE_SIZE; off += AGE_PROBE_CHUNK) {
+		res = _fs_read(st->sess, obj, st->buf, AGE_PROBE_CHUNK,
+			       &count);
+		if (!ADBG_EXPECT_TEEC_SUCCESS(c, res) ||
+		    !ADBG_EXPECT_COMPARE_UNSIGNED(c, count, ==,
+						  AGE_PROBE_CHUNK)) {
+			res = TEEC_ERROR_GENERIC;
+			goto unlink;
+		}
+	}
+	read_ns = xtest_bench_now_ns() - read_ns;
+
+	res = fs_alloc_enum(st->sess, &e);
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, res))
+		goto unlink;
+
+	enum_ns = xtest_bench_now_ns();
+	res = fs_start_enum(st->sess, e, st->storage_id);
+	while (res == TEEC_SUCCESS) {
+		res = fs_next_enum(st->sess, e, NULL, 0, found_id,
+				   sizeof(found_id));
+		if (res == TEEC_SUCCESS)
+			found++;
+	}
+	enum_ns = xtest_bench_now_ns() - enum_ns;
+
+	ADBG_EXPECT_TEEC_SUCCESS(c, fs_free_enum(st->sess, e));
+	if (!ADBG_EXPECT_TEEC_RESULT(c, TEEC_ERROR_ITEM_NOT_FOUND, res))
+		goto unlink;
+	res = TEEC_SUCCESS;
+
+	for (n = 0; n < AGE_POOL; n++)
+		live += st->live[n];
+
+	printk("    round %3zu, %2zu live objects: write " XTEST_BENCH_MILLI_FMT
+	       " MiB/s, read " XTEST_BENCH_MILLI_FMT " MiB/s, enumeration "
+	       XTEST_BENCH_US_FMT " us (%zu objects)\n", round, live,
+	       XTEST_BENCH_MILLI(xtest_bench_mib_milli(AGE_PROBE_SIZE,
+						       write_ns)),
+	       XTEST_BENCH_MILLI(xtest_bench_mib_milli(AGE_PROBE_SIZE,
+						       read_ns)),
+	       XTEST_BENCH_US(enum_ns), found);
+
+unlink:
+	ADBG_EXPECT_TEEC_SUCCESS(c, _fs_unlink(st->sess, obj));
+	return res == TEEC_SUCCESS;
+}
+
+static void age_bench(ADBG_Case_t *c, uint32_t storage_id)
+{
+	TEEC_Session sess = { };
+	struct age_state *st = NULL;
+	uint32_t orig = 0;
+	uint32_t obj = 0;
+	size_t round = 0;
+	size_t n = 0;
+
+	st = k_calloc(1, sizeof(*st));
+	if (!ADBG_EXPECT_NOT_NULL(c, st))
+		return;
+
+	st->buf = k_malloc(MAX(AGE_MAX_CHUNK, AGE_PROBE_CHUNK));
+	if (!ADBG_EXPECT_NOT_NULL(c, st->buf))
+		goto out;
+	memset(st->buf, 0x3c, MAX(AGE_MAX_CHUNK, AGE_PROBE_CHUNK));
+
+	if (!ADBG_EXPECT_TEEC_SUCCESS(c, xtest_teec_open_session(&sess,
+					&storage_ta_uuid, NULL, &orig)))
+		goto out;
+
+	st->sess = &sess;
+	st->storage_id = storage_id;
+	st->seed = AGE_SEED;
+
+	Do_ADBG_Log("    %d rounds of %d churn operations on %d objects",
+		    AGE_ROUNDS, AGE_OPS, AGE_POOL);
+
+	for (round = 0; round <= AGE_ROUNDS; round++) {
+		for (n = 0; round && n < AGE_OPS; n++) {
+			if (!ADBG_EXPECT_TEEC_SUCCESS(c, age_churn_one(st)))
+				goto cleanup;
+		}
+
+		if (!age_probe(c, st, round))
+			goto cleanup;
+	}
+
+	Do_ADBG_Log("    churn: %zu create, %zu extend, %zu truncate, %zu delete",
+		    st->ops[AGE_CREATE], st->ops[AGE_EXTEND],
+		    st->ops[AGE_TRUNCATE], st->ops[AGE_DELETE]);
+
+cleanup:
+	for (n = 0; n < AGE_POOL; n++) {
+		if (!st->live[n])
+			continue;
+		if (ADBG_EXPECT_TEEC_SUCCESS(c, age_open(st, n, false, 0,
+							 &obj)))
+			ADBG_EXPECT_TEEC_SUCCESS(c, _fs_unlink(&sess, obj));
+	}
+	TEEC_CloseSession(&sess);
+out:
+	k_free(st->buf);
+	k_free(st);
+}
+
+ZTEST(storage_benchmark, test_6007)
+{
+	ADBG_STRUCT_DECLARE("Storage aging");
+
+	for_each_storage_backend(&c, age_bench);
+	ADBG_Assert(&c);
+}
+
+ZTEST_SUITE(storage_benchmark, NULL, storage_benchmark_init, NULL, NULL,
+	    storage_benchmark_deinit);
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2014, STMicroelectronics International N.V.
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#ifndef STORAGE_HELPERS_H
+#define STORAGE_HELPERS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+#include <tee_client_api.h>
+
+/*
+ * Wrappers around the storage TA commands (TA_STORAGE_CMD_*). Some names
+ * carry a leading underscore to not clash with the Zephyr fs API.
+ */
+TEEC_Result _fs_open(TEEC_Session *sess, void *id, uint32_t id_size,
+		     uint32_t flags, uint32_t *obj, uint32_t storage_id);
+TEEC_Result fs_create(TEEC_Session *sess, void *id, uint32_t id_size,
+		      uint32_t flags, uint32_t attr, void *data,
+		      uint32_t data_size, uint32_t *obj,
+		      uint32_t storage_id);
+TEEC_Result fs_create_overwrite(TEEC_Session *sess, void *id,
+				uint32_t id_size, uint32_t storage_id);
+TEEC_Result _fs_close(TEEC_Session *sess, uint32_t obj);
+TEEC_Result _fs_read(TEEC_Session *sess, uint32_t obj, void *data,
+		     uint32_t data_size, uint32_t *count);
+TEEC_Result _fs_write(TEEC_Session *sess, uint32_t obj, void *data,
+		      uint32_t data_size);
+/*
+ * Running count of the data bytes accepted by the storage TA through
+ * fs_create() and _fs_write(), wraps around at 2^32
+ */
+uint32_t fs_written_bytes(void);
+TEEC_Result _fs_seek(TEEC_Session *sess, uint32_t obj, int32_t offset,
+		     int32_t whence);
+TEEC_Result _fs_unlink(TEEC_Session *sess, uint32_t obj);
+TEEC_Result fs_trunc(TEEC_Session *sess, uint32_t obj, uint32_t len);
+TEEC_Result _fs_rename(TEEC_Session *sess, uint32_t obj, void *id,
+		       uint32_t id_size);
+TEEC_Result fs_alloc_enum(TEEC_Session *sess, uint32_t *e);
+TEEC_Result fs_reset_enum(TEEC_Session *sess, uint32_t e);
+TEEC_Result fs_free_enum(TEEC_Session *sess, uint32_t e);
+TEEC_Result fs_start_enum(TEEC_Session *sess, uint32_t e,
+			  uint32_t storage_id);
+TEEC_Result fs_next_enum(TEEC_Session *sess, uint32_t e, void *obj_info,
+			 size_t info_size, void *id, uint32_t id_size);
+TEEC_Result fs_restrict_usage(TEEC_Session *sess, uint32_t obj,
+			      uint32_t obj_usage);
+TEEC_Result fs_alloc_obj(TEEC_Session *sess, uint32_t obj_type,
+			 uint32_t max_key_size, uint32_t *obj);
+TEEC_Result fs_free_obj(TEEC_Session *sess, uint32_t obj);
+TEEC_Result fs_reset_obj(TEEC_Session *sess, uint32_t obj);
+TEEC_Result fs_get_obj_info(TEEC_Session *sess, uint32_t obj,
+			    void *obj_info, size_t info_size);
+
+/* Record availability of all secure storage types at runtime */
+struct storage_info {
+	uint32_t id;
+	bool available;
+};
+
+#define STORAGE_INFO_COUNT	3
+
+extern struct storage_info storage_info[STORAGE_INFO_COUNT];
+
+TEE_Result init_storage_info(void);
+bool is_storage_available(uint32_t id);
+/* Resolve TEE_STORAGE_PRIVATE to the backend it maps to */
+uint32_t real_id_for(uint32_t id);
+bool storage_is(uint32_t id1, uint32_t id2);
+
+#endif /*STORAGE_HELPERS_H*/
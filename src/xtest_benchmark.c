@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/sys_heap.h>
+
+#include "xtest_benchmark.h"
+
+/* Resolution of the largest free block search */
+#define HEAP_PROBE_GRANULE	64
+
+/* k_malloc() heap, defined by the kernel */
+extern struct k_heap _system_heap;
+
+int xtest_bench_stats_init(struct xtest_bench_stats *s, size_t max_samples)
+{
+	memset(s, 0, sizeof(*s));
+	s->min_ns = UINT64_MAX;
+
+	if (!max_samples)
+		return 0;
+
+	s->samples = k_malloc(max_samples * sizeof(*s->samples));
+	if (!s->samples)
+		return -ENOMEM;
+	s->max_samples = max_samples;
+
+	return 0;
+}
+
+void xtest_bench_stats_reset(struct xtest_bench_stats *s)
+{
+	s->count = 0;
+	s->total_ns = 0;
+	s->min_ns = UINT64_MAX;
+	s->max_ns = 0;
+	s->sorted = false;
+}
+
+void xtest_bench_stats_free(struct xtest_bench_stats *s)
+{
+	k_free(s->samples);
+	memset(s, 0, sizeof(*s));
+}
+
+void xtest_bench_stats_add(struct xtest_bench_stats *s, uint64_t ns)
+{
+	if (s->count < s->max_samples) {
+		s->samples[s->count] = ns;
+		s->sorted = false;
+	}
+
+	s->count++;
+	s->total_ns += ns;
+	if (ns < s->min_ns)
+		s->min_ns = ns;
+	if (ns > s->max_ns)
+		s->max_ns = ns;
+}
+
+uint64_t xtest_bench_stats_mean(const struct xtest_bench_stats *s)
+{
+	if (!s->count)
+		return 0;
+
+	return s->total_ns / s->count;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t va = *(const uint64_t *)a;
+	uint64_t vb = *(const uint64_t *)b;
+
+	if (va < vb)
+		return -1;
+	return va > vb;
+}
+
+uint64_t xtest_bench_stats_percentile(struct xtest_bench_stats *s,
+				      unsigned int pct)
+{
+	size_t n = MIN(s->count, s->max_samples);
+	size_t idx = 0;
+
+	if (!n)
+		return s->count ? s->max_ns : 0;
+
+	if (!s->sorted) {
+		qsort(s->samples, n, sizeof(*s->samples), cmp_u64);
+		s->sorted = true;
+	}
+
+	/* Nearest-rank percentile */
+	idx = DIV_ROUND_UP(MIN(pct, 100U) * n, 100U);
+	if (idx)
+		idx--;
+
+	return s->samples[idx];
+}
+
+uint64_t xtest_bench_rate_milli(uint64_t count, uint64_t ns)
+{
+	if (!ns)
+		return 0;
+
+	if (count <= UINT64_MAX / (1000ULL * NSEC_PER_SEC))
+		return count * 1000ULL * NSEC_PER_SEC / ns;
+
+	/* Large byte counts: trade nanosecond resolution for range */
+	return count * 1000ULL * USEC_PER_SEC / MAX(ns / NSEC_PER_USEC, 1);
+}
+
+uint64_t xtest_bench_mib_milli(uint64_t bytes, uint64_t ns)
+{
+	return xtest_bench_rate_milli(bytes, ns) / (1024 * 1024);
+}
+
+void xtest_bench_stats_print(const char *label, struct xtest_bench_stats *s)
+{
+	uint64_t min_ns = s->count ? s->min_ns : 0;
+	uint64_t p50 = xtest_bench_stats_percentile(s, 50);
+	uint64_t p99 = xtest_bench_stats_percentile(s, 99);
+
+	printk("    %-40s n %6zu  min " XTEST_BENCH_US_FMT
+	       "  mean " XTEST_BENCH_US_FMT "  p50 " XTEST_BENCH_US_FMT
+	       "  p99 " XTEST_BENCH_US_FMT "  max " XTEST_BENCH_US_FMT
+	       " us  " XTEST_BENCH_MILLI_FMT " op/s\n",
+	       label, s->count, XTEST_BENCH_US(min_ns),
+	       XTEST_BENCH_US(xtest_bench_stats_mean(s)), XTEST_BENCH_US(p50),
+	       XTEST_BENCH_US(p99), XTEST_BENCH_US(s->max_ns),
+	       XTEST_BENCH_MILLI(xtest_bench_rate_milli(s->count,
+							s->total_ns)));
+}
+
+void xtest_bench_stats_histogram(struct xtest_bench_stats *s)
+{
+	/* Bucket 0 is [0, 1) us, bucket n is [2^(n-1), 2^n) us */
+	size_t buckets[32] = { };
+	size_t n = MIN(s->count, s->max_samples);
+	size_t b = 0;
+	size_t i = 0;
+
+	for (i = 0; i < n; i++) {
+		uint64_t us = s->samples[i] / NSEC_PER_USEC;
+
+		for (b = 0; us && b < ARRAY_SIZE(buckets) - 1; b++)
+			us >>= 1;
+		buckets[b]++;
+	}
+
+	for (b = 0; b < ARRAY_SIZE(buckets); b++) {
+		if (buckets[b])
+			printk("    %10lu .. %10lu us %8zu\n",
+			       b ? BIT(b - 1) : 0UL, BIT(b), buckets[b]);
+	}
+}
+
+void xtest_bench_print_mib(const char *label, uint64_t bytes, uint64_t ns)
+{
+	printk("    %-40s %10" PRIu64 " bytes  " XTEST_BENCH_US_FMT " us  "
+	       XTEST_BENCH_MILLI_FMT " MiB/s\n", label, bytes,
+	       XTEST_BENCH_US(ns),
+	       XTEST_BENCH_MILLI(xtest_bench_mib_milli(bytes, ns)));
+}
+
+int xtest_bench_heap_get(struct xtest_bench_heap *h)
+{
+	struct sys_memory_stats st = { };
+	size_t lo = 0;
+	size_t hi = 0;
+	size_t mid = 0;
+	void *p = NULL;
+	int rc = 0;
+
+	memset(h, 0, sizeof(*h));
+
+	rc = sys_heap_runtime_stats_get(&_system_heap.heap, &st);
+	if (rc)
+		return rc;
+
+	h->free_bytes = st.free_bytes;
+	h->allocated_bytes = st.allocated_bytes;
+	h->max_allocated_bytes = st.max_allocated_bytes;
+
+	/* Bisect on allocation success, free bytes is the upper bound */
+	hi = st.free_bytes;
+	while (hi - lo > HEAP_PROBE_GRANULE) {
+		mid = lo + (hi - lo) / 2;
+		p = k_malloc(mid);
+		if (p) {
+			k_free(p);
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	h->largest_free = lo;
+
+	return 0;
+}
+
+void xtest_bench_heap_print(const char *label,
+			    const struct xtest_bench_heap *h)
+{
+	uint64_t frag = 0;
+
+	/* Percent scaled by 1000 */
+	if (h->free_bytes)
+		frag = (uint64_t)(h->free_bytes - h->largest_free) * 100000 /
+		       h->free_bytes;
+
+	printk("    %-40s %8zu B free  %8zu B allocated  %8zu B peak  "
+	       "%8zu B largest free block  " XTEST_BENCH_MILLI_FMT
+	       " %% fragmented\n", label, h->free_bytes, h->allocated_bytes,
+	       h->max_allocated_bytes, h->largest_free,
+	       XTEST_BENCH_MILLI(frag));
+}
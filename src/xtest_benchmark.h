@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#ifndef XTEST_BENCHMARK_H
+#define XTEST_BENCHMARK_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/*
+ * Helpers shared by the benchmark suites.
+ *
+ * Sample storage and benchmark buffers are taken from the system heap
+ * (k_malloc(), CONFIG_HEAP_MEM_POOL_SIZE): the libc malloc arena is only
+ * CONFIG_MINIMAL_LIBC_MALLOC_ARENA_SIZE bytes.
+ */
+
+/* Print a nanosecond value as microseconds with three decimals */
+#define XTEST_BENCH_US_FMT	"%" PRIu64 ".%03" PRIu64
+#define XTEST_BENCH_US(ns)	((uint64_t)(ns) / NSEC_PER_USEC), \
+				((uint64_t)(ns) % NSEC_PER_USEC)
+
+/* Print a value scaled by 1000 with three decimals */
+#define XTEST_BENCH_MILLI_FMT	"%" PRIu64 ".%03" PRIu64
+#define XTEST_BENCH_MILLI(v)	((uint64_t)(v) / 1000), ((uint64_t)(v) % 1000)
+
+/* Monotonic timestamp in nanoseconds */
+static inline uint64_t xtest_bench_now_ns(void)
+{
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+	return k_cyc_to_ns_floor64(k_cycle_get_64());
+#else
+	return k_ticks_to_ns_floor64(k_uptime_ticks());
+#endif
+}
+
+/* Deterministic pseudo random numbers for workloads, xorshift32 */
+static inline uint32_t xtest_bench_rand(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+/*
+ * Latency accumulator. Min/max/total are tracked for every sample, the
+ * first @max_samples samples are also kept for percentiles.
+ */
+struct xtest_bench_stats {
+	uint64_t *samples;
+	size_t max_samples;
+	size_t count;
+	uint64_t total_ns;
+	uint64_t min_ns;
+	uint64_t max_ns;
+	bool sorted;
+};
+
+int xtest_bench_stats_init(struct xtest_bench_stats *s, size_t max_samples);
+void xtest_bench_stats_reset(struct xtest_bench_stats *s);
+void xtest_bench_stats_free(struct xtest_bench_stats *s);
+void xtest_bench_stats_add(struct xtest_bench_stats *s, uint64_t ns);
+uint64_t xtest_bench_stats_mean(const struct xtest_bench_stats *s);
+/* @pct in range [0, 100], sorts the kept samples */
+uint64_t xtest_bench_stats_percentile(struct xtest_bench_stats *s,
+				      unsigned int pct);
+
+/* @count events in @ns nanoseconds as events per second, scaled by 1000 */
+uint64_t xtest_bench_rate_milli(uint64_t count, uint64_t ns);
+/* @bytes moved in @ns nanoseconds as MiB/s, scaled by 1000 */
+uint64_t xtest_bench_mib_milli(uint64_t bytes, uint64_t ns);
+
+/*
+ * One line report: sample count, min/mean/p50/p99/max latency and the
+ * resulting operations per second.
+ */
+void xtest_bench_stats_print(const char *label, struct xtest_bench_stats *s);
+
+/*
+ * Latency histogram of the kept samples, one line per non-empty power of
+ * two bucket of microseconds.
+ */
+void xtest_bench_stats_histogram(struct xtest_bench_stats *s);
+
+/* One line report: @bytes moved in @ns nanoseconds, in MiB/s */
+void xtest_bench_print_mib(const char *label, uint64_t bytes, uint64_t ns);
+
+/*
+ * System heap usage. @largest_free is the largest block k_malloc() can
+ * return, found by trial allocations: it is only accurate while no other
+ * thread allocates.
+ */
+struct xtest_bench_heap {
+	size_t free_bytes;
+	size_t allocated_bytes;
+	size_t max_allocated_bytes;
+	size_t largest_free;
+};
+
+/* Returns 0 or a negative errno from sys_heap_runtime_stats_get() */
+int xtest_bench_heap_get(struct xtest_bench_heap *h);
+/* One line report, with the share of free memory outside the largest block */
+void xtest_bench_heap_print(const char *label,
+			    const struct xtest_bench_heap *h);
+
+#endif /*XTEST_BENCHMARK_H*/
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <string.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/kernel.h>
+#include <zephyr/stats/stats.h>
+#include <zephyr/ztest.h>
+
+#include "storage_helpers.h"
+#include "xtest_benchmark.h"
+
+/*
+ * Flash wear accounting: the flash simulator statistics are sampled
+ * before and after every test case, and the cases which touched the flash
+ * get a summary of the bytes read and programmed and of the erases, also
+ * given per byte of object data written through the storage TA.
+ */
+
+#define FLASH_SIM_STATS_GROUP	"flash_sim_stats"
+/* Per erase unit counters, when the simulator keeps them */
+#define ERASE_UNIT_PREFIX	"erase_cycles_unit"
+
+#if DT_NODE_EXISTS(DT_NODELABEL(flash_sim0))
+#define ERASE_BLOCK_SIZE	DT_PROP(DT_NODELABEL(flash_sim0), \
+					erase_block_size)
+#else
+#define ERASE_BLOCK_SIZE	0
+#endif
+
+/* Counters are 32-bit and may wrap, deltas are computed modulo 2^32 */
+struct flash_counters {
+	uint32_t bytes_read;
+	uint32_t bytes_written;
+	uint32_t double_writes;
+	uint32_t erase_calls;
+	uint32_t erased_units;
+	uint32_t ta_bytes;
+};
+
+static struct flash_counters before;
+
+static int read_counter(struct stats_hdr *hdr, void *arg, const char *name,
+			uint16_t off)
+{
+	struct flash_counters *fc = arg;
+	uint8_t *p = (uint8_t *)hdr + off;
+	uint32_t v = 0;
+
+	if (hdr->s_size == sizeof(uint64_t))
+		v = *(uint64_t *)p;
+	else if (hdr->s_size == sizeof(uint32_t))
+		v = *(uint32_t *)p;
+	else
+		v = *(uint16_t *)p;
+
+	if (!strcmp(name, "bytes_read"))
+		fc->bytes_read = v;
+	else if (!strcmp(name, "bytes_written"))
+		fc->bytes_written = v;
+	else if (!strcmp(name, "double_writes"))
+		fc->double_writes = v;
+	else if (!strcmp(name, "flash_erase_calls"))
+		fc->erase_calls = v;
+	else if (!strncmp(name, ERASE_UNIT_PREFIX,
+			  strlen(ERASE_UNIT_PREFIX)))
+		fc->erased_units += v;
+
+	return 0;
+}
+
+static bool read_counters(struct flash_counters *fc)
+{
+	struct stats_hdr *hdr = stats_group_find(FLASH_SIM_STATS_GROUP);
+
+	memset(fc, 0, sizeof(*fc));
+	if (!hdr)
+		return false;
+
+	stats_walk(hdr, read_counter, fc);
+	fc->ta_bytes = fs_written_bytes();
+
+	return true;
+}
+
+/* Ratio scaled by 1000 */
+static uint64_t per_ta_byte(uint64_t v, uint32_t ta_bytes)
+{
+	return v * 1000 / ta_bytes;
+}
+
+static void flash_stats_before(const struct ztest_unit_test *test,
+			       void *data)
+{
+	read_counters(&before);
+}
+
+static void flash_stats_after(const struct ztest_unit_test *test, void *data)
+{
+	struct flash_counters after = { };
+	struct flash_counters d = { };
+	uint32_t erases = 0;
+	uint64_t erased_bytes = 0;
+
+	if (!read_counters(&after))
+		return;
+
+	d.bytes_read = after.bytes_read - before.bytes_read;
+	d.bytes_written = after.bytes_written - before.bytes_written;
+	d.double_writes = after.double_writes - before.double_writes;
+	d.erase_calls = after.erase_calls - before.erase_calls;
+	d.erased_units = after.erased_units - before.erased_units;
+	d.ta_bytes = after.ta_bytes - before.ta_bytes;
+
+	if (!d.bytes_read && !d.bytes_written && !d.erase_calls)
+		return;
+
+	/* Erase calls may cover several units */
+	erases = d.erased_units ? d.erased_units : d.erase_calls;
+	erased_bytes = (uint64_t)erases * ERASE_BLOCK_SIZE;
+
+	printk("flash %s.%s: read %u B, programmed %u B, %u erases (%" PRIu64 " B), %u double writes, TA wrote %u B\n",
+	       test->test_suite_name, test->name, d.bytes_read,
+	       d.bytes_written, erases, erased_bytes, d.double_writes,
+	       d.ta_bytes);
+
+	if (d.ta_bytes)
+		printk("    per TA byte: programmed " XTEST_BENCH_MILLI_FMT
+		       " B, erased " XTEST_BENCH_MILLI_FMT " B, read "
+		       XTEST_BENCH_MILLI_FMT " B\n",
+		       XTEST_BENCH_MILLI(per_ta_byte(d.bytes_written,
+						     d.ta_bytes)),
+		       XTEST_BENCH_MILLI(per_ta_byte(erased_bytes,
+						     d.ta_bytes)),
+		       XTEST_BENCH_MILLI(per_ta_byte(d.bytes_read,
+						     d.ta_bytes)));
+}
+
+ZTEST_RULE(xtest_flash_stats, flash_stats_before, flash_stats_after);
@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/fs/fs_sys.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#include "xtest_benchmark.h"
+#include "xtest_fs_trace.h"
+#ifdef CONFIG_XTEST_RAMFS
+#include "xtest_ramfs.h"
+#endif
+
+#if DT_NODE_EXISTS(DT_NODELABEL(storage))
+FS_FSTAB_DECLARE_ENTRY(DT_NODELABEL(storage));
+#define BOARD_TEE_MNT		(&FS_FSTAB_ENTRY(DT_NODELABEL(storage)))
+#endif
+
+/* Name of the REE FS directory file, next to the object files */
+#define DIRF_NAME		"dirf.db"
+#define MAX_DIRF_FILES		4
+
+static const char * const op_names[XTEST_FS_TRACE_OP_COUNT] = {
+	[XTEST_FS_TRACE_OPEN] = "open",
+	[XTEST_FS_TRACE_CLOSE] = "close",
+	[XTEST_FS_TRACE_READ] = "read",
+	[XTEST_FS_TRACE_WRITE] = "write",
+	[XTEST_FS_TRACE_TRUNCATE] = "truncate",
+	[XTEST_FS_TRACE_SYNC] = "sync",
+	[XTEST_FS_TRACE_RENAME] = "rename",
+	[XTEST_FS_TRACE_UNLINK] = "unlink",
+};
+
+static struct k_spinlock trace_lock;
+static struct xtest_fs_trace trace;
+/* Open handles on the directory file */
+static const struct fs_file_t *dirf_files[MAX_DIRF_FILES];
+
+static struct fs_mount_t *traced_mp;
+static const struct fs_file_system_t *orig_fs;
+static struct fs_file_system_t trace_fs;
+
+static void account(struct xtest_fs_trace_op *op, uint64_t start,
+		    ssize_t bytes)
+{
+	uint64_t ns = xtest_bench_now_ns() - start;
+	k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+	op->count++;
+	op->ns += ns;
+	if (bytes > 0)
+		op->bytes += bytes;
+
+	k_spin_unlock(&trace_lock, key);
+}
+
+static bool is_dirf(const char *path)
+{
+	const char *name = strrchr(path, '/');
+
+	return !strcmp(name ? name + 1 : path, DIRF_NAME);
+}
+
+/* Replaces @old by @new in dirf_files[], returns false if not found */
+static bool replace_dirf_file(const struct fs_file_t *old,
+			      const struct fs_file_t *new)
+{
+	k_spinlock_key_t key = k_spin_lock(&trace_lock);
+	bool found = false;
+	size_t i = 0;
+
+	for (i = 0; i < ARRAY_SIZE(dirf_files); i++) {
+		if (dirf_files[i] == old) {
+			dirf_files[i] = new;
+			found = true;
+			break;
+		}
+	}
+
+	k_spin_unlock(&trace_lock, key);
+
+	return found;
+}
+
+static bool is_dirf_file(const struct fs_file_t *filp)
+{
+	return replace_dirf_file(filp, filp);
+}
+
+static int trace_open(struct fs_file_t *filp, const char *fs_path,
+		      fs_mode_t flags)
+{
+	uint64_t start = xtest_bench_now_ns();
+	int rc = orig_fs->open(filp, fs_path, flags);
+
+	account(&trace.op[XTEST_FS_TRACE_OPEN], start, 0);
+	if (!rc && is_dirf(fs_path))
+		replace_dirf_file(NULL, filp);
+
+	return rc;
+}
+
+static int trace_close(struct fs_file_t *filp)
+{
+	uint64_t start = xtest_bench_now_ns();
+	int rc = orig_fs->close(filp);
+
+	account(&trace.op[XTEST_FS_TRACE_CLOSE], start, 0);
+	replace_dirf_file(filp, NULL);
+
+	return rc;
+}
+
+static ssize_t trace_read(struct fs_file_t *filp, void *dest, size_t nbytes)
+{
+	uint64_t start = xtest_bench_now_ns();
+	ssize_t rc = orig_fs->read(filp, dest, nbytes);
+
+	account(&trace.op[XTEST_FS_TRACE_READ], start, rc);
+
+	return rc;
+}
+
+static ssize_t trace_write(struct fs_file_t *filp, const void *src,
+			   size_t nbytes)
+{
+	uint64_t start = xtest_bench_now_ns();
+	ssize_t rc = orig_fs->write(filp, src, nbytes);
+
+	account(&trace.op[XTEST_FS_TRACE_WRITE], start, rc);
+	if (is_dirf_file(filp))
+		account(&trace.dirf_write, start, rc);
+
+	return rc;
+}
+
+static int trace_truncate(struct fs_file_t *filp, off_t length)
+{
+	uint64_t start = xtest_bench_now_ns();
+	int rc = orig_fs->truncate(filp, length);
+
+	account(&trace.op[XTEST_FS_TRACE_TRUNCATE], start, 0);
+
+	return rc;
+}
+
+static int trace_sync(struct fs_file_t *filp)
+{
+	uint64_t start = xtest_bench_now_ns();
+	int rc = orig_fs->sync(filp);
+
+	account(&trace.op[XTEST_FS_TRACE_SYNC], start, 0);
+
+	return rc;
+}
+
+static int trace_rename(struct fs_mount_t *mountp, const char *from,
+			const char *to)
+{
+	uint64_t start = xtest_bench_now_ns();
+	int rc = orig_fs->rename(mountp, from, to);
+
+	account(&trace.op[XTEST_FS_TRACE_RENAME], start, 0);
+
+	return rc;
+}
+
+static int trace_unlink(struct fs_mount_t *mountp, const char *name)
+{
+	uint64_t start = xtest_bench_now_ns();
+	int rc = orig_fs->unlink(mountp, name);
+
+	account(&trace.op[XTEST_FS_TRACE_UNLINK], start, 0);
+
+	return rc;
+}
+
+static struct fs_mount_t *tee_mount(void)
+{
+#ifdef CONFIG_XTEST_RAMFS
+	if (xtest_ramfs_is_mounted())
+		return &xtest_ramfs_mnt;
+#endif
+#ifdef BOARD_TEE_MNT
+	if (BOARD_TEE_MNT->fs)
+		return BOARD_TEE_MNT;
+#endif
+	return NULL;
+}
+
+int xtest_fs_trace_start(void)
+{
+	struct fs_mount_t *mp = tee_mount();
+	k_spinlock_key_t key = { };
+
+	if (!mp)
+		return -ENODEV;
+
+	key = k_spin_lock(&trace_lock);
+	memset(&trace, 0, sizeof(trace));
+	memset(dirf_files, 0, sizeof(dirf_files));
+	k_spin_unlock(&trace_lock, key);
+
+	if (mp->fs == &trace_fs)
+		return 0;
+
+	/* Untraced operations go straight to the wrapped filesystem */
+	orig_fs = mp->fs;
+	trace_fs = *orig_fs;
+	trace_fs.open = trace_open;
+	trace_fs.close = trace_close;
+	trace_fs.read = trace_read;
+	trace_fs.write = trace_write;
+	trace_fs.truncate = trace_truncate;
+	trace_fs.sync = trace_sync;
+	trace_fs.rename = trace_rename;
+	trace_fs.unlink = trace_unlink;
+
+	traced_mp = mp;
+	mp->fs = &trace_fs;
+
+	return 0;
+}
+
+void xtest_fs_trace_stop(struct xtest_fs_trace *out)
+{
+	k_spinlock_key_t key = { };
+
+	if (traced_mp && traced_mp->fs == &trace_fs)
+		traced_mp->fs = orig_fs;
+	traced_mp = NULL;
+
+	key = k_spin_lock(&trace_lock);
+	*out = trace;
+	k_spin_unlock(&trace_lock, key);
+}
+
+void xtest_fs_trace_print(const char *label, const struct xtest_fs_trace *t)
+{
+	size_t i = 0;
+
+	printk("fs trace %s\n", label);
+	for (i = 0; i < ARRAY_SIZE(t->op); i++) {
+		if (!t->op[i].count)
+			continue;
+		printk("    %-14s %8" PRIu64 " calls %10" PRIu64 " bytes  "
+		       XTEST_BENCH_US_FMT " us\n", op_names[i], t->op[i].count,
+		       t->op[i].bytes, XTEST_BENCH_US(t->op[i].ns));
+	}
+
+	if (t->dirf_write.count)
+		printk("    %-14s %8" PRIu64 " calls %10" PRIu64 " bytes  "
+		       XTEST_BENCH_US_FMT " us\n", "write " DIRF_NAME,
+		       t->dirf_write.count, t->dirf_write.bytes,
+		       XTEST_BENCH_US(t->dirf_write.ns));
+}
+
+static void fs_trace_before(const struct ztest_unit_test *test, void *data)
+{
+	(void)xtest_fs_trace_start();
+}
+
+static void fs_trace_after(const struct ztest_unit_test *test, void *data)
+{
+	struct xtest_fs_trace t = { };
+	char label[64] = { };
+	uint64_t calls = 0;
+	size_t i = 0;
+
+	xtest_fs_trace_stop(&t);
+
+	for (i = 0; i < ARRAY_SIZE(t.op); i++)
+		calls += t.op[i].count;
+	if (!calls)
+		return;
+
+	snprintk(label, sizeof(label), "%s.%s", test->test_suite_name,
+		 test->name);
+	xtest_fs_trace_print(label, &t);
+}
+
+ZTEST_RULE(xtest_fs_trace, fs_trace_before, fs_trace_after);
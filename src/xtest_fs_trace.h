@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#ifndef XTEST_FS_TRACE_H
+#define XTEST_FS_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Counting and timing of the filesystem calls made under /tee, i.e. by
+ * the tee-supplicant REE FS on behalf of OP-TEE.
+ *
+ * The operations of the filesystem mounted on /tee are wrapped between
+ * xtest_fs_trace_start() and xtest_fs_trace_stop(). A ztest rule does so
+ * around every test case and prints the summary of the cases which
+ * touched /tee. A remount of /tee within a case ends the trace of that
+ * mount.
+ */
+
+enum xtest_fs_trace_op_id {
+	XTEST_FS_TRACE_OPEN,
+	XTEST_FS_TRACE_CLOSE,
+	XTEST_FS_TRACE_READ,
+	XTEST_FS_TRACE_WRITE,
+	XTEST_FS_TRACE_TRUNCATE,
+	XTEST_FS_TRACE_SYNC,
+	XTEST_FS_TRACE_RENAME,
+	XTEST_FS_TRACE_UNLINK,
+	XTEST_FS_TRACE_OP_COUNT,
+};
+
+struct xtest_fs_trace_op {
+	uint64_t count;
+	/* Bytes moved, read and write only */
+	uint64_t bytes;
+	uint64_t ns;
+};
+
+struct xtest_fs_trace {
+	struct xtest_fs_trace_op op[XTEST_FS_TRACE_OP_COUNT];
+	/* Share of the writes going to the REE FS directory file */
+	struct xtest_fs_trace_op dirf_write;
+};
+
+/* Returns 0 or -ENODEV when nothing is mounted on /tee */
+int xtest_fs_trace_start(void);
+void xtest_fs_trace_stop(struct xtest_fs_trace *trace);
+void xtest_fs_trace_print(const char *label,
+			  const struct xtest_fs_trace *trace);
+
+#endif /*XTEST_FS_TRACE_H*/
@@ -0,0 +1,826 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/fs/fs_sys.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/dlist.h>
+
+#include "xtest_ramfs.h"
+
+/* Only used to report sizes in statvfs */
+#define RAMFS_BLOCK_SIZE	512
+
+#if DT_NODE_EXISTS(DT_NODELABEL(storage))
+FS_FSTAB_DECLARE_ENTRY(DT_NODELABEL(storage));
+#define BOARD_TEE_MNT		(&FS_FSTAB_ENTRY(DT_NODELABEL(storage)))
+#endif
+
+/*
+ * Each node holds its own name and a link to its parent directory. Nodes
+ * are looked up through a hash of (parent, name), one probe per path
+ * component whatever the number of files, and each directory keeps the
+ * list of its children for readdir and rename.
+ */
+#define RAMFS_HASH_BUCKETS	256
+
+struct ramfs_node {
+	/* Entry in the children list of the parent directory */
+	sys_dnode_t node;
+	/* Entry in the hash bucket */
+	sys_dnode_t hash_node;
+	struct ramfs_node *parent;
+	sys_dlist_t children;
+	char *name;
+	bool is_dir;
+	/* Unlinked while open, freed on last close */
+	bool unlinked;
+	unsigned int open_count;
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+};
+
+struct ramfs_file {
+	struct ramfs_node *node;
+	size_t pos;
+};
+
+struct ramfs_dir {
+	/* Entry in ramfs_dirs */
+	sys_dnode_t node;
+	struct ramfs_node *dir;
+	/* Last entry returned, NULL before the first one */
+	struct ramfs_node *last;
+};
+
+static K_MUTEX_DEFINE(ramfs_lock);
+/* File data, kept apart from the system heap used by TEEC and the tests */
+static K_HEAP_DEFINE(ramfs_heap, CONFIG_XTEST_RAMFS_SIZE);
+/* The root directory is not hashed, it always exists */
+static struct ramfs_node ramfs_root = {
+	.children = SYS_DLIST_STATIC_INIT(&ramfs_root.children),
+	.is_dir = true,
+};
+static sys_dlist_t ramfs_hash[RAMFS_HASH_BUCKETS];
+/* Open directories, repositioned when their last entry is unlinked */
+static sys_dlist_t ramfs_dirs = SYS_DLIST_STATIC_INIT(&ramfs_dirs);
+/* Bytes allocated for file data */
+static size_t ramfs_used;
+static bool ramfs_mounted;
+static bool board_unmounted;
+
+static const char *rel_path(const struct fs_mount_t *mp, const char *path)
+{
+	path += mp->mountp_len;
+	while (*path == '/')
+		path++;
+
+	return path;
+}
+
+static const char *base_name(const char *path)
+{
+	const char *slash = strrchr(path, '/');
+
+	return slash ? slash + 1 : path;
+}
+
+/* FNV-1a of the parent node address and the name */
+static sys_dlist_t *hash_bucket(struct ramfs_node *parent, const char *name,
+				size_t len)
+{
+	uint32_t hash = 2166136261U ^ (uint32_t)(uintptr_t)parent;
+	size_t n = 0;
+
+	for (n = 0; n < len; n++)
+		hash = (hash ^ (uint8_t)name[n]) * 16777619U;
+
+	return ramfs_hash + hash % RAMFS_HASH_BUCKETS;
+}
+
+static struct ramfs_node *find_child(struct ramfs_node *parent,
+				     const char *name, size_t len)
+{
+	struct ramfs_node *n = NULL;
+
+	SYS_DLIST_FOR_EACH_CONTAINER(hash_bucket(parent, name, len), n,
+				     hash_node) {
+		if (n->parent == parent && !strncmp(n->name, name, len) &&
+		    !n->name[len])
+			return n;
+	}
+
+	return NULL;
+}
+
+/* Returns the node of the @len first characters of @path, or the root */
+static struct ramfs_node *find_node(const char *path, size_t len)
+{
+	struct ramfs_node *n = &ramfs_root;
+	const char *end = path + len;
+	const char *sep = NULL;
+
+	while (path < end) {
+		if (!n->is_dir)
+			return NULL;
+
+		sep = memchr(path, '/', end - path);
+		if (!sep)
+			sep = end;
+		n = find_child(n, path, sep - path);
+		if (!n)
+			return NULL;
+		path = sep + 1;
+	}
+
+	return n;
+}
+
+/* Finds the directory @path is to be created in */
+static int find_parent(const char *path, struct ramfs_node **parent)
+{
+	const char *slash = strrchr(path, '/');
+	struct ramfs_node *n = &ramfs_root;
+
+	if (slash) {
+		n = find_node(path, slash - path);
+		if (!n)
+			return -ENOENT;
+		if (!n->is_dir)
+			return -ENOTDIR;
+	}
+
+	*parent = n;
+
+	return 0;
+}
+
+static bool has_children(struct ramfs_node *dir)
+{
+	return !sys_dlist_is_empty(&dir->children);
+}
+
+static void link_node(struct ramfs_node *n, struct ramfs_node *parent)
+{
+	n->parent = parent;
+	sys_dlist_append(&parent->children, &n->node);
+	sys_dlist_append(hash_bucket(parent, n->name, strlen(n->name)),
+			 &n->hash_node);
+}
+
+static void unlink_node(struct ramfs_node *n)
+{
+	sys_dnode_t *prev = sys_dlist_peek_prev(&n->parent->children, &n->node);
+	struct ramfs_dir *d = NULL;
+
+	/* Readers positioned on @n resume after its predecessor */
+	SYS_DLIST_FOR_EACH_CONTAINER(&ramfs_dirs, d, node) {
+		if (d->last == n)
+			d->last = prev ? CONTAINER_OF(prev, struct ramfs_node,
+						      node) : NULL;
+	}
+
+	sys_dlist_remove(&n->node);
+	sys_dlist_remove(&n->hash_node);
+}
+
+static struct ramfs_node *new_node(struct ramfs_node *parent,
+				   const char *name, bool is_dir)
+{
+	struct ramfs_node *n = k_calloc(1, sizeof(*n));
+
+	if (!n)
+		return NULL;
+
+	n->name = k_malloc(strlen(name) + 1);
+	if (!n->name) {
+		k_free(n);
+		return NULL;
+	}
+	strcpy(n->name, name);
+	n->is_dir = is_dir;
+	sys_dlist_init(&n->children);
+	link_node(n, parent);
+
+	return n;
+}
+
+static void free_node(struct ramfs_node *n)
+{
+	ramfs_used -= n->capacity;
+	k_heap_free(&ramfs_heap, n->data);
+	k_free(n->name);
+	k_free(n);
+}
+
+static void remove_node(struct ramfs_node *n)
+{
+	unlink_node(n);
+	if (n->open_count)
+		n->unlinked = true;
+	else
+		free_node(n);
+}
+
+static int resize_node(struct ramfs_node *n, size_t size)
+{
+	size_t capacity = MAX(n->capacity * 2, size);
+	uint8_t *data = NULL;
+
+	if (size > n->capacity) {
+		/* Grow geometrically, within the configured budget */
+		if (ramfs_used - n->capacity + capacity >
+		    CONFIG_XTEST_RAMFS_SIZE)
+			capacity = size;
+		if (ramfs_used - n->capacity + capacity >
+		    CONFIG_XTEST_RAMFS_SIZE)
+			return -ENOSPC;
+
+		data = k_heap_alloc(&ramfs_heap, capacity, K_NO_WAIT);
+		/* Old and new buffers coexist, the doubled one may not fit */
+		if (!data && capacity > size) {
+			capacity = size;
+			data = k_heap_alloc(&ramfs_heap, capacity, K_NO_WAIT);
+		}
+		if (!data)
+			return -ENOSPC;
+		if (n->size)
+			memcpy(data, n->data, n->size);
+		k_heap_free(&ramfs_heap, n->data);
+		ramfs_used += capacity - n->capacity;
+		n->data = data;
+		n->capacity = capacity;
+	}
+
+	if (size > n->size)
+		memset(n->data + n->size, 0, size - n->size);
+	n->size = size;
+
+	return 0;
+}
+
+static void fill_dirent(struct ramfs_node *n, struct fs_dirent *entry)
+{
+	entry->type = n->is_dir ? FS_DIR_ENTRY_DIR : FS_DIR_ENTRY_FILE;
+	strncpy(entry->name, n->name, sizeof(entry->name) - 1);
+	entry->name[sizeof(entry->name) - 1] = '\0';
+	entry->size = n->size;
+}
+
+static int ramfs_open(struct fs_file_t *filp, const char *fs_path,
+		      fs_mode_t flags)
+{
+	const char *path = rel_path(filp->mp, fs_path);
+	struct ramfs_node *parent = NULL;
+	struct ramfs_file *f = NULL;
+	struct ramfs_node *n = NULL;
+	int rc = 0;
+
+	if (!*path)
+		return -EISDIR;
+
+	f = k_malloc(sizeof(*f));
+	if (!f)
+		return -ENOMEM;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	n = find_node(path, strlen(path));
+	if (!n) {
+		if (!(flags & FS_O_CREATE)) {
+			rc = -ENOENT;
+			goto out;
+		}
+		rc = find_parent(path, &parent);
+		if (rc)
+			goto out;
+		n = new_node(parent, base_name(path), false);
+		if (!n) {
+			rc = -ENOMEM;
+			goto out;
+		}
+	} else if (n->is_dir) {
+		rc = -EISDIR;
+		goto out;
+	}
+
+#ifdef FS_O_TRUNC
+	if (flags & FS_O_TRUNC)
+		n->size = 0;
+#endif
+
+	n->open_count++;
+	f->node = n;
+	f->pos = 0;
+	filp->filep = f;
+out:
+	k_mutex_unlock(&ramfs_lock);
+	if (rc)
+		k_free(f);
+
+	return rc;
+}
+
+static ssize_t ramfs_read(struct fs_file_t *filp, void *dest, size_t nbytes)
+{
+	struct ramfs_file *f = filp->filep;
+	struct ramfs_node *n = f->node;
+	size_t len = 0;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	if (f->pos < n->size) {
+		len = MIN(nbytes, n->size - f->pos);
+		memcpy(dest, n->data + f->pos, len);
+		f->pos += len;
+	}
+	k_mutex_unlock(&ramfs_lock);
+
+	return len;
+}
+
+static ssize_t ramfs_write(struct fs_file_t *filp, const void *src,
+			   size_t nbytes)
+{
+	struct ramfs_file *f = filp->filep;
+	struct ramfs_node *n = f->node;
+	size_t size = 0;
+	int rc = 0;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	if (filp->flags & FS_O_APPEND)
+		f->pos = n->size;
+
+	size = MAX(n->size, f->pos + nbytes);
+	rc = resize_node(n, size);
+	if (!rc) {
+		memcpy(n->data + f->pos, src, nbytes);
+		f->pos += nbytes;
+	}
+
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc ? rc : (ssize_t)nbytes;
+}
+
+static int ramfs_lseek(struct fs_file_t *filp, off_t off, int whence)
+{
+	struct ramfs_file *f = filp->filep;
+	off_t base = 0;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	switch (whence) {
+	case FS_SEEK_SET:
+		base = 0;
+		break;
+	case FS_SEEK_CUR:
+		base = f->pos;
+		break;
+	case FS_SEEK_END:
+		base = f->node->size;
+		break;
+	default:
+		k_mutex_unlock(&ramfs_lock);
+		return -EINVAL;
+	}
+	k_mutex_unlock(&ramfs_lock);
+
+	if (base + off < 0)
+		return -EINVAL;
+	f->pos = base + off;
+
+	return 0;
+}
+
+static off_t ramfs_tell(struct fs_file_t *filp)
+{
+	struct ramfs_file *f = filp->filep;
+
+	return f->pos;
+}
+
+static int ramfs_truncate(struct fs_file_t *filp, off_t length)
+{
+	struct ramfs_file *f = filp->filep;
+	int rc = 0;
+
+	if (length < 0)
+		return -EINVAL;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	rc = resize_node(f->node, length);
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_sync(struct fs_file_t *filp)
+{
+	return 0;
+}
+
+static int ramfs_close(struct fs_file_t *filp)
+{
+	struct ramfs_file *f = filp->filep;
+	struct ramfs_node *n = f->node;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	n->open_count--;
+	if (n->unlinked && !n->open_count)
+		free_node(n);
+	k_mutex_unlock(&ramfs_lock);
+
+	k_free(f);
+	filp->filep = NULL;
+
+	return 0;
+}
+
+static int ramfs_opendir(struct fs_dir_t *dirp, const char *fs_path)
+{
+	const char *path = rel_path(dirp->mp, fs_path);
+	struct ramfs_node *n = NULL;
+	struct ramfs_dir *d = NULL;
+	int rc = 0;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	n = find_node(path, strlen(path));
+	if (!n) {
+		rc = -ENOENT;
+		goto out;
+	}
+	if (!n->is_dir) {
+		rc = -ENOTDIR;
+		goto out;
+	}
+
+	d = k_malloc(sizeof(*d));
+	if (!d) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	/* Keeps the node alive if the directory is removed while open */
+	n->open_count++;
+	d->dir = n;
+	d->last = NULL;
+	sys_dlist_append(&ramfs_dirs, &d->node);
+	dirp->dirp = d;
+out:
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_readdir(struct fs_dir_t *dirp, struct fs_dirent *entry)
+{
+	struct ramfs_dir *d = dirp->dirp;
+	sys_dlist_t *children = &d->dir->children;
+	sys_dnode_t *dn = NULL;
+
+	/* An empty name marks the end of the directory */
+	entry->name[0] = '\0';
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	if (d->last)
+		dn = sys_dlist_peek_next(children, &d->last->node);
+	else
+		dn = sys_dlist_peek_head(children);
+	if (dn) {
+		d->last = CONTAINER_OF(dn, struct ramfs_node, node);
+		fill_dirent(d->last, entry);
+	}
+
+	k_mutex_unlock(&ramfs_lock);
+
+	return 0;
+}
+
+static int ramfs_closedir(struct fs_dir_t *dirp)
+{
+	struct ramfs_dir *d = dirp->dirp;
+	struct ramfs_node *n = d->dir;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	sys_dlist_remove(&d->node);
+	n->open_count--;
+	if (n->unlinked && !n->open_count)
+		free_node(n);
+	k_mutex_unlock(&ramfs_lock);
+
+	k_free(d);
+	dirp->dirp = NULL;
+
+	return 0;
+}
+
+static int ramfs_mount(struct fs_mount_t *mountp)
+{
+	int rc = 0;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	if (ramfs_mounted)
+		rc = -EBUSY;
+	else
+		ramfs_mounted = true;
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_unmount(struct fs_mount_t *mountp)
+{
+	struct ramfs_node *n = NULL;
+	struct ramfs_node *next = NULL;
+	size_t b = 0;
+	int rc = 0;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	if (ramfs_root.open_count) {
+		rc = -EBUSY;
+		goto out;
+	}
+	for (b = 0; b < RAMFS_HASH_BUCKETS; b++) {
+		SYS_DLIST_FOR_EACH_CONTAINER(ramfs_hash + b, n, hash_node) {
+			if (n->open_count) {
+				rc = -EBUSY;
+				goto out;
+			}
+		}
+	}
+
+	for (b = 0; b < RAMFS_HASH_BUCKETS; b++) {
+		SYS_DLIST_FOR_EACH_CONTAINER_SAFE(ramfs_hash + b, n, next,
+						  hash_node) {
+			sys_dlist_remove(&n->hash_node);
+			free_node(n);
+		}
+	}
+	sys_dlist_init(&ramfs_root.children);
+	ramfs_mounted = false;
+out:
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_unlink(struct fs_mount_t *mountp, const char *name)
+{
+	const char *path = rel_path(mountp, name);
+	struct ramfs_node *n = NULL;
+	int rc = 0;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	n = find_node(path, strlen(path));
+	if (!n)
+		rc = -ENOENT;
+	else if (n == &ramfs_root)
+		rc = -EBUSY;
+	else if (n->is_dir && has_children(n))
+		rc = -ENOTEMPTY;
+	else
+		remove_node(n);
+
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_rename(struct fs_mount_t *mountp, const char *from,
+			const char *to)
+{
+	struct ramfs_node *parent = NULL;
+	struct ramfs_node *src = NULL;
+	struct ramfs_node *dst = NULL;
+	size_t from_len = 0;
+	char *name = NULL;
+	int rc = 0;
+
+	from = rel_path(mountp, from);
+	to = rel_path(mountp, to);
+	from_len = strlen(from);
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	src = find_node(from, from_len);
+	if (!src) {
+		rc = -ENOENT;
+		goto out;
+	}
+	if (src == &ramfs_root || !*to) {
+		rc = -EBUSY;
+		goto out;
+	}
+	if (!strncmp(to, from, from_len) && to[from_len] == '/') {
+		rc = -EINVAL;
+		goto out;
+	}
+	rc = find_parent(to, &parent);
+	if (rc)
+		goto out;
+
+	/* Like rename(2), an existing destination is replaced */
+	dst = find_node(to, strlen(to));
+	if (dst == src)
+		goto out;
+	if (dst) {
+		if (dst->is_dir != src->is_dir) {
+			rc = dst->is_dir ? -EISDIR : -ENOTDIR;
+			goto out;
+		}
+		if (dst->is_dir && has_children(dst)) {
+			rc = -ENOTEMPTY;
+			goto out;
+		}
+	}
+
+	name = k_malloc(strlen(base_name(to)) + 1);
+	if (!name) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	strcpy(name, base_name(to));
+
+	if (dst)
+		remove_node(dst);
+
+	/* Children are keyed on their parent node, they move along */
+	unlink_node(src);
+	k_free(src->name);
+	src->name = name;
+	link_node(src, parent);
+out:
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_mkdir(struct fs_mount_t *mountp, const char *name)
+{
+	const char *path = rel_path(mountp, name);
+	struct ramfs_node *parent = NULL;
+	int rc = 0;
+
+	if (!*path)
+		return -EEXIST;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+
+	if (find_node(path, strlen(path)))
+		rc = -EEXIST;
+	else
+		rc = find_parent(path, &parent);
+	if (!rc && !new_node(parent, base_name(path), true))
+		rc = -ENOMEM;
+
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_stat(struct fs_mount_t *mountp, const char *path,
+		      struct fs_dirent *entry)
+{
+	struct ramfs_node *n = NULL;
+	int rc = 0;
+
+	path = rel_path(mountp, path);
+	if (!*path) {
+		entry->type = FS_DIR_ENTRY_DIR;
+		entry->name[0] = '\0';
+		entry->size = 0;
+		return 0;
+	}
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	n = find_node(path, strlen(path));
+	if (n)
+		fill_dirent(n, entry);
+	else
+		rc = -ENOENT;
+	k_mutex_unlock(&ramfs_lock);
+
+	return rc;
+}
+
+static int ramfs_statvfs(struct fs_mount_t *mountp, const char *path,
+			 struct fs_statvfs *stat)
+{
+	stat->f_bsize = RAMFS_BLOCK_SIZE;
+	stat->f_frsize = RAMFS_BLOCK_SIZE;
+	stat->f_blocks = CONFIG_XTEST_RAMFS_SIZE / RAMFS_BLOCK_SIZE;
+
+	k_mutex_lock(&ramfs_lock, K_FOREVER);
+	stat->f_bfree = (CONFIG_XTEST_RAMFS_SIZE - ramfs_used) /
+			RAMFS_BLOCK_SIZE;
+	k_mutex_unlock(&ramfs_lock);
+
+	return 0;
+}
+
+static const struct fs_file_system_t ramfs_fs = {
+	.open = ramfs_open,
+	.read = ramfs_read,
+	.write = ramfs_write,
+	.lseek = ramfs_lseek,
+	.tell = ramfs_tell,
+	.truncate = ramfs_truncate,
+	.sync = ramfs_sync,
+	.close = ramfs_close,
+	.opendir = ramfs_opendir,
+	.readdir = ramfs_readdir,
+	.closedir = ramfs_closedir,
+	.mount = ramfs_mount,
+	.unmount = ramfs_unmount,
+	.unlink = ramfs_unlink,
+	.rename = ramfs_rename,
+	.mkdir = ramfs_mkdir,
+	.stat = ramfs_stat,
+	.statvfs = ramfs_statvfs,
+};
+
+struct fs_mount_t xtest_ramfs_mnt = {
+	.type = XTEST_RAMFS_TYPE,
+	.mnt_point = XTEST_RAMFS_MNT_POINT,
+};
+
+bool xtest_ramfs_is_mounted(void)
+{
+	return ramfs_mounted;
+}
+
+int xtest_ramfs_mount_tee(void)
+{
+	int rc = 0;
+
+#ifdef BOARD_TEE_MNT
+	if (BOARD_TEE_MNT->fs) {
+		rc = fs_unmount(BOARD_TEE_MNT);
+		if (rc)
+			return rc;
+		board_unmounted = true;
+	}
+#endif
+
+	rc = fs_mount(&xtest_ramfs_mnt);
+#ifdef BOARD_TEE_MNT
+	if (rc && board_unmounted && !fs_mount(BOARD_TEE_MNT))
+		board_unmounted = false;
+#endif
+
+	return rc;
+}
+
+int xtest_ramfs_unmount_tee(void)
+{
+	int rc = fs_unmount(&xtest_ramfs_mnt);
+
+	if (rc)
+		return rc;
+
+#ifdef BOARD_TEE_MNT
+	if (board_unmounted) {
+		rc = fs_mount(BOARD_TEE_MNT);
+		if (!rc)
+			board_unmounted = false;
+	}
+#endif
+
+	return rc;
+}
+
+static int xtest_ramfs_init(void)
+{
+	size_t b = 0;
+	int rc = 0;
+
+	for (b = 0; b < RAMFS_HASH_BUCKETS; b++)
+		sys_dlist_init(ramfs_hash + b);
+
+	rc = fs_register(XTEST_RAMFS_TYPE, &ramfs_fs);
+	if (rc) {
+		printk("Failed to register RAM filesystem: %d\n", rc);
+		return rc;
+	}
+
+	if (IS_ENABLED(CONFIG_XTEST_RAMFS_AUTOMOUNT)) {
+		rc = xtest_ramfs_mount_tee();
+		if (rc)
+			printk("Failed to mount RAM filesystem on %s: %d\n",
+			       XTEST_RAMFS_MNT_POINT, rc);
+	}
+
+	return rc;
+}
+
+SYS_INIT(xtest_ramfs_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, EPAM Systems
+ */
+
+#ifndef XTEST_RAMFS_H
+#define XTEST_RAMFS_H
+
+#include <stdbool.h>
+#include <zephyr/fs/fs.h>
+
+/*
+ * In-memory filesystem for the tee-supplicant REE FS directory.
+ *
+ * Files only live in a dedicated heap of CONFIG_XTEST_RAMFS_SIZE bytes:
+ * with /tee on it, storage timings carry the OP-TEE, supplicant and fs API
+ * costs but no flash or on-disk filesystem cost.
+ */
+
+#define XTEST_RAMFS_TYPE	FS_TYPE_EXTERNAL_BASE
+#define XTEST_RAMFS_MNT_POINT	"/tee"
+
+/* Mount point of the RAM filesystem */
+extern struct fs_mount_t xtest_ramfs_mnt;
+
+/*
+ * Move /tee to the RAM filesystem: the filesystem mounted there from the
+ * board fstab, if any, is unmounted first. Nothing must be open under
+ * /tee, i.e. no persistent object may be open in the TEE.
+ */
+int xtest_ramfs_mount_tee(void);
+
+/*
+ * Unmount the RAM filesystem from /tee, dropping all its files, and
+ * mount back the board filesystem.
+ */
+int xtest_ramfs_unmount_tee(void);
+
+bool xtest_ramfs_is_mounted(void);
+
+#endif /*XTEST_RAMFS_H*/